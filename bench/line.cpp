@@ -0,0 +1,151 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+
+#include "line.hpp"
+
+/* benchmark of LINE::index against std::string::find loop
+// that parseShow() used before LINE::index.
+// input is output of git show --patch given as argument,
+// or synthetic patch of same shape if it is omitted.
+// usage: make bench [BENCH_INPUT=<file>]
+*/
+
+namespace
+{
+
+const int ITERATIONS = 10;
+const std::size_t SYNTHETIC_SIZE = 64 * 1024 * 1024;
+
+// lines of git show --unified=0 with short and long lines.
+std::string synthesize()
+{
+    std::mt19937 gen(0);
+    std::uniform_int_distribution<int> length(0, 120), count(1, 8);
+
+    std::string str;
+    str.reserve(SYNTHETIC_SIZE + 4096);
+    for(int file = 0; str.size() < SYNTHETIC_SIZE; file++)
+    {
+        str += "diff --git src/file" + std::to_string(file) + ".cpp src/file" + std::to_string(file) + ".cpp\n"
+            "index 0123456..89abcde 100644\n"
+            "--- src/file" + std::to_string(file) + ".cpp\n"
+            "+++ src/file" + std::to_string(file) + ".cpp\n";
+        for(int hunk = 0; hunk < 16; hunk++)
+        {
+            str += "@@ -" + std::to_string(hunk * 10) + ",2 +" + std::to_string(hunk * 10) + ",3 @@\n";
+            for(int i = count(gen); i > 0; i--)
+                str += '-' + std::string(length(gen), 'x') + '\n';
+            for(int i = count(gen); i > 0; i--)
+                str += '+' + std::string(length(gen), 'y') + '\n';
+        }
+    }
+    return str;
+}
+
+LINE::Kind classify(const std::string &line)
+{
+    if(line.compare(0, 4, "+++ ") == 0)
+        return LINE::Kind::DST;
+    if(line.compare(0, 4, "--- ") == 0)
+        return LINE::Kind::SRC;
+    if(line.compare(0, 2, "@@") == 0)
+        return LINE::Kind::HUNK;
+    if(!line.empty() && line.front() == '+')
+        return LINE::Kind::ADD;
+    if(!line.empty() && line.front() == '-')
+        return LINE::Kind::SUB;
+    if(!line.empty() && line.front() == '\\')
+        return LINE::Kind::NOTE;
+    return LINE::Kind::OTHER;
+}
+
+// each line is copied and classified, as parseShow() did with PATH::getLine().
+std::vector<LINE::Line> baseline(const std::string &str)
+{
+    std::vector<LINE::Line> lines;
+    std::string line;
+    for(std::string::size_type pos = 0; pos < str.size();)
+    {
+        std::string::size_type np = str.find('\n', pos);
+        if(np == std::string::npos)
+            np = str.size();
+        line = str.substr(pos, np - pos);
+        lines.push_back(LINE::Line{pos, np - pos, classify(line)});
+        pos = np + 1;
+    }
+    return lines;
+}
+
+template<class Function>
+double measure(const std::string &str
+    , Function &&function
+    , std::vector<LINE::Line> &lines)
+{
+    double best = 0.0;
+    for(int i = 0; i < ITERATIONS; i++)
+    {
+        auto begin = std::chrono::steady_clock::now();
+        lines = function(str);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+        if(i == 0 || elapsed.count() < best)
+            best = elapsed.count();
+    }
+    return best;
+}
+
+}
+
+int main(int argc
+    , char **argv)
+{
+    std::string str;
+    if(argc > 1)
+    {
+        std::ifstream fstr(argv[1], std::ios::binary);
+        if(!fstr.is_open())
+        {
+            std::cerr << "bench error:\n"
+                "    what: failed to open input.\n"
+                "    file: " << argv[1] << "\n"
+                << std::flush;
+            return EXIT_FAILURE;
+        }
+        std::ostringstream sstr;
+        sstr << fstr.rdbuf();
+        str = sstr.str();
+    }
+    else
+        str = synthesize();
+
+    std::vector<LINE::Line> expected, actual;
+    double findTime = measure(str, baseline, expected);
+    double indexTime = measure(str
+        , [](const std::string &s){return LINE::index(s);}
+        , actual);
+
+    bool isSame = expected.size() == actual.size();
+    for(std::size_t i = 0; isSame && i < expected.size(); i++)
+        isSame = expected[i].pos == actual[i].pos
+            && expected[i].size == actual[i].size
+            && expected[i].kind == actual[i].kind;
+    if(!isSame)
+    {
+        std::cerr << "bench error:\n"
+            "    what: LINE::index differs from std::string::find loop.\n"
+            << std::flush;
+        return EXIT_FAILURE;
+    }
+
+    double mib = static_cast<double>(str.size()) / (1024 * 1024);
+    std::cout << "input: " << mib << " MiB, " << actual.size() << " lines\n"
+        << "std::string::find: " << findTime * 1000 << " ms, " << mib / findTime << " MiB/s\n"
+        << "LINE::index:       " << indexTime * 1000 << " ms, " << mib / indexTime << " MiB/s\n"
+        << "speedup:           " << findTime / indexTime << "x" << std::endl;
+    return EXIT_SUCCESS;
+}
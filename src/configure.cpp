@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <exception>
 #include <iostream>
 
@@ -67,6 +68,149 @@ bool Configure::loadConfigure()
     else
         isSuccessful = false;
 
+    if(auto opt = tree.get_optional<std::string>(REGISTRY_FILE_KEY); opt)
+        REGISTRY_FILE = opt.get();
+    else
+        isSuccessful = false;
+
+    for(auto &&[key, value] : {std::make_pair(&SHOW_THREADS_KEY, &SHOW_THREADS)
+        , std::make_pair(&PARSE_THREADS_KEY, &PARSE_THREADS)
+        , std::make_pair(&SERIALIZE_THREADS_KEY, &SERIALIZE_THREADS)
+        , std::make_pair(&WRITE_THREADS_KEY, &WRITE_THREADS)
+        , std::make_pair(&QUEUE_CAPACITY_KEY, &QUEUE_CAPACITY)})
+    {
+        if(auto opt = tree.get_optional<int>(*key); opt && opt.get() > 0)
+            *value = opt.get();
+        else
+            isSuccessful = false;
+    }
+
+    if(auto opt = tree.get_optional<bool>(PIPELINE_METRICS_KEY); opt)
+        PIPELINE_METRICS = opt.get();
+    else
+        isSuccessful = false;
+
+    if(auto opt = tree.get_optional<std::size_t>(PIPELINE_MEMORY_BUDGET_KEY); opt && opt.get() > 0)
+        PIPELINE_MEMORY_BUDGET = opt.get();
+    else
+        isSuccessful = false;
+
+    if(auto opt = tree.get_optional<int>(SHARD_INSTANCES_KEY); opt && opt.get() > 0)
+        SHARD_INSTANCES = opt.get();
+    else
+        isSuccessful = false;
+
+    if(auto opt = tree.get_optional<int>(SHARD_INSTANCE_KEY);
+        opt && opt.get() >= 0 && opt.get() < SHARD_INSTANCES)
+        SHARD_INSTANCE = opt.get();
+    else
+        isSuccessful = false;
+
+    if(auto opt = tree.get_optional<int>(SHARD_VNODES_KEY); opt && opt.get() > 0)
+        SHARD_VNODES = opt.get();
+    else
+        isSuccessful = false;
+
+    if(auto opt = tree.get_optional<std::string>(LEASE_DIR_KEY); opt)
+        LEASE_DIR = opt.get();
+    else
+        isSuccessful = false;
+
+    if(auto opt = tree.get_optional<long long>(LEASE_DURATION_KEY); opt && opt.get() > 0)
+        LEASE_DURATION = opt.get();
+    else
+        isSuccessful = false;
+
+    if(auto opt = tree.get_optional<bool>(PROBE_KEY); opt)
+        PROBE = opt.get();
+    else
+        isSuccessful = false;
+
+    if(auto opt = tree.get_optional<int>(PROBE_THREADS_KEY); opt && opt.get() > 0)
+        PROBE_THREADS = opt.get();
+    else
+        isSuccessful = false;
+
+    if(auto opt = tree.get_optional<int>(PROBE_HOST_CONCURRENCY_KEY); opt && opt.get() > 0)
+        PROBE_HOST_CONCURRENCY = opt.get();
+    else
+        isSuccessful = false;
+
+    if(auto opt = tree.get_optional<bool>(MAINTENANCE_KEY); opt)
+        MAINTENANCE = opt.get();
+    else
+        isSuccessful = false;
+
+    for(auto &&[key, value] : {std::make_pair(&MAINTENANCE_PACK_THRESHOLD_KEY, &MAINTENANCE_PACK_THRESHOLD)
+        , std::make_pair(&MAINTENANCE_LOOSE_THRESHOLD_KEY, &MAINTENANCE_LOOSE_THRESHOLD)})
+    {
+        if(auto opt = tree.get_optional<std::size_t>(*key); opt)
+            *value = opt.get();
+        else
+            isSuccessful = false;
+    }
+
+    if(auto opt = tree.get_optional<long long>(MAINTENANCE_INTERVAL_KEY); opt && opt.get() > 0)
+        MAINTENANCE_INTERVAL = opt.get();
+    else
+        isSuccessful = false;
+
+    if(auto opt = tree.get_optional<bool>(MAINTENANCE_METRICS_KEY); opt)
+        MAINTENANCE_METRICS = opt.get();
+    else
+        isSuccessful = false;
+
+    if(auto opt = tree.get_optional<bool>(COPROCESS_KEY); opt)
+        COPROCESS = opt.get();
+    else
+        isSuccessful = false;
+
+    if(auto opt = tree.get_optional<std::string>(DIFF_ENGINE_KEY);
+        opt && (opt.get() == DIFF_ENGINE_GIT || opt.get() == DIFF_ENGINE_NATIVE))
+        DIFF_ENGINE = opt.get();
+    else
+        isSuccessful = false;
+
+    if(auto opt = tree.get_optional<std::size_t>(COMMIT_MEMORY_BUDGET_KEY); opt && opt.get() > 0)
+        COMMIT_MEMORY_BUDGET = opt.get();
+    else
+        isSuccessful = false;
+
+    if(auto opt = tree.get_optional<std::string>(OVERSIZE_POLICY_KEY);
+        opt && (opt.get() == OVERSIZE_TRUNCATE
+            || opt.get() == OVERSIZE_NUMSTAT
+            || opt.get() == OVERSIZE_SKIP))
+        OVERSIZE_POLICY = opt.get();
+    else
+        isSuccessful = false;
+
+    if(auto optarr = tree.get_child_optional(LOG_FIELDS_KEY); optarr)
+    {
+        std::vector<std::string> fields;
+        for(auto &&c : optarr.get())
+        {
+            std::string name(c.second.data());
+            if(std::find(LOG_FIELD_NAMES.begin(), LOG_FIELD_NAMES.end(), name) != LOG_FIELD_NAMES.end()
+                && std::find(fields.begin(), fields.end(), name) == fields.end())
+                fields.push_back(name);
+            else
+                isSuccessful = false;
+        }
+        LOG_FIELDS = fields;
+    }
+    else
+        isSuccessful = false;
+
+    if(auto opt = tree.get_optional<bool>(LOG_NUMSTAT_KEY); opt)
+        LOG_NUMSTAT = opt.get();
+    else
+        isSuccessful = false;
+
+    if(auto opt = tree.get_optional<std::string>(TRACE_FILE_KEY); opt)
+        TRACE_FILE = opt.get();
+    else
+        isSuccessful = false;
+
     if(!isSuccessful)
     {
         std::cerr << "read-configure-file warning:\n"
@@ -85,6 +229,7 @@ bool Configure::loadRepositories()
     using namespace boost;
 
     REPOSITORIES_MAP.clear();
+    REPOSITORIES_REFS.clear();
 
     if(!PATH::isExist(REPOSITORIES_JSON_FILE))
     {
@@ -117,6 +262,12 @@ bool Configure::loadRepositories()
             if(optname && opturl)
             {
                 auto [iter, isValid] = REPOSITORIES_MAP.emplace(optname.get(), opturl.get());
+                if(auto optrefs = c.second.get_child_optional(REPOSITORIES_REFS_KEY); optrefs && isValid)
+                {
+                    std::vector<std::string> &refs = REPOSITORIES_REFS[optname.get()];
+                    for(auto &&r : optrefs.get())
+                        refs.push_back(r.second.data());
+                }
                 if(!isValid)
                 {
                     std::cerr << "load-repositories warning:\n"
@@ -3,7 +3,9 @@
 
 #include <filesystem>
 #include <unordered_map>
+#include <vector>
 #include <string>
+#include <cstddef>
 
 class Configure;
 
@@ -19,11 +21,110 @@ private:
     inline static std::filesystem::path REPOSITORIES_DIR = "./repositories";
     inline static std::filesystem::path DIFFERENCE_DIR = "./difference";
     inline static int LOOP_RANGE = 24;
+    inline static const std::string REGISTRY_FILE_KEY = "registry_file";
+    inline static std::filesystem::path REGISTRY_FILE = "./registry.json";
+
+    inline static const std::string SHOW_THREADS_KEY = "pipeline.show_threads";
+    inline static const std::string PARSE_THREADS_KEY = "pipeline.parse_threads";
+    inline static const std::string SERIALIZE_THREADS_KEY = "pipeline.serialize_threads";
+    inline static const std::string WRITE_THREADS_KEY = "pipeline.write_threads";
+    inline static const std::string QUEUE_CAPACITY_KEY = "pipeline.queue_capacity";
+    inline static const std::string PIPELINE_METRICS_KEY = "pipeline.metrics";
+    // bytes of records of all commits in pipeline of one repository.
+    inline static const std::string PIPELINE_MEMORY_BUDGET_KEY = "pipeline.memory_budget";
+    inline static int SHOW_THREADS = 2;
+    inline static int PARSE_THREADS = 2;
+    inline static int SERIALIZE_THREADS = 1;
+    inline static int WRITE_THREADS = 1;
+    inline static int QUEUE_CAPACITY = 16;
+    inline static bool PIPELINE_METRICS = false;
+    inline static std::size_t PIPELINE_MEMORY_BUDGET = 256 * 1024 * 1024;
+
+    inline static const std::string SHARD_INSTANCE_KEY = "shard.instance";
+    inline static const std::string SHARD_INSTANCES_KEY = "shard.instances";
+    inline static const std::string SHARD_VNODES_KEY = "shard.vnodes";
+    inline static const std::string LEASE_DIR_KEY = "shard.lease_dir";
+    inline static const std::string LEASE_DURATION_KEY = "shard.lease_duration";
+    inline static int SHARD_INSTANCE = 0;
+    inline static int SHARD_INSTANCES = 1;
+    inline static int SHARD_VNODES = 64;
+    inline static std::filesystem::path LEASE_DIR = "./leases";
+    inline static long long LEASE_DURATION = 2 * 24 * 60 * 60;
+
+    inline static const std::string PROBE_KEY = "probe.enabled";
+    inline static const std::string PROBE_THREADS_KEY = "probe.threads";
+    inline static const std::string PROBE_HOST_CONCURRENCY_KEY = "probe.host_concurrency";
+    inline static bool PROBE = true;
+    inline static int PROBE_THREADS = 8;
+    inline static int PROBE_HOST_CONCURRENCY = 4;
+
+    inline static const std::string MAINTENANCE_KEY = "maintenance.enabled";
+    inline static const std::string MAINTENANCE_PACK_THRESHOLD_KEY = "maintenance.pack_threshold";
+    inline static const std::string MAINTENANCE_LOOSE_THRESHOLD_KEY = "maintenance.loose_threshold";
+    inline static const std::string MAINTENANCE_INTERVAL_KEY = "maintenance.interval";
+    inline static const std::string MAINTENANCE_METRICS_KEY = "maintenance.metrics";
+    inline static bool MAINTENANCE = true;
+    inline static std::size_t MAINTENANCE_PACK_THRESHOLD = 16;
+    inline static std::size_t MAINTENANCE_LOOSE_THRESHOLD = 1024;
+    inline static long long MAINTENANCE_INTERVAL = 7 * 24 * 60 * 60;
+    inline static bool MAINTENANCE_METRICS = false;
+
+    inline static const std::string COPROCESS_KEY = "coprocess";
+    inline static bool COPROCESS = true;
+
+    inline static const std::string DIFF_ENGINE_KEY = "diff_engine";
+    inline static std::string DIFF_ENGINE = "git";
+
+    // estimated size of records of one commit. records are built into one tree,
+    // and serialize stage writes JSON from it to file directly, so JSON text is not counted.
+    // total of commits in flight is bounded by pipeline.memory_budget.
+    inline static const std::string COMMIT_MEMORY_BUDGET_KEY = "commit.memory_budget";
+    inline static const std::string OVERSIZE_POLICY_KEY = "commit.oversize_policy";
+    inline static std::size_t COMMIT_MEMORY_BUDGET = 64 * 1024 * 1024;
+    inline static std::string OVERSIZE_POLICY = "truncate";
+
+    inline static const std::string LOG_FIELDS_KEY = "log.fields";
+    inline static const std::string LOG_NUMSTAT_KEY = "log.numstat";
+    inline static bool LOG_NUMSTAT = true;
+
+    inline static const std::string TRACE_FILE_KEY = "trace_file";
+    inline static std::filesystem::path TRACE_FILE = "";
 
     inline static const std::string REPOSITORIES_KEY = "repositories";
     inline static const std::string REPOSITORIES_NAME_KEY = "name";
     inline static const std::string REPOSITORIES_URL_KEY = "url";
+    inline static const std::string REPOSITORIES_REFS_KEY = "refs";
     inline static std::unordered_map<std::string, std::string> REPOSITORIES_MAP;
+    inline static std::unordered_map<std::string, std::vector<std::string>> REPOSITORIES_REFS;
+
+public:
+    // policies for commit whose records exceed commit.memory_budget.
+    // truncate: keep records read within budget.
+    // numstat: replace records with line counts of each file.
+    // skip: output only hash, subject and marker.
+    inline static const std::string OVERSIZE_TRUNCATE = "truncate";
+    inline static const std::string OVERSIZE_NUMSTAT = "numstat";
+    inline static const std::string OVERSIZE_SKIP = "skip";
+
+    // git: parse output of git show.
+    // native: read blobs and compute difference in process.
+    inline static const std::string DIFF_ENGINE_GIT = "git";
+    inline static const std::string DIFF_ENGINE_NATIVE = "native";
+
+    // fields that log.fields can select in addition to hash and subject.
+    // times are seconds since epoch. parents also adds merge flag,
+    // and it is omitted for root commit, because empty array cannot be written to JSON.
+    inline static const std::vector<std::string> LOG_FIELD_NAMES = {"author_name"
+        , "author_email"
+        , "author_time"
+        , "committer_name"
+        , "committer_email"
+        , "committer_time"
+        , "parents"};
+
+private:
+    // all fields are selected by default.
+    inline static std::vector<std::string> LOG_FIELDS = LOG_FIELD_NAMES;
 
 public:
     Configure() = delete;
@@ -39,8 +140,80 @@ public:
         {return DIFFERENCE_DIR;}
     static const std::unordered_map<std::string, std::string> repositoriesMap() noexcept
         {return REPOSITORIES_MAP;};
+    // glob patterns of refs collected in addition to HEAD. empty if not specified.
+    static std::vector<std::string> repositoryRefs(const std::string &name)
+    {
+        auto iter = REPOSITORIES_REFS.find(name);
+        return iter != REPOSITORIES_REFS.end()
+            ? iter->second
+                : std::vector<std::string>();
+    }
     static int loopRange() noexcept
         {return LOOP_RANGE;}
+    static const std::filesystem::path &registryFile() noexcept
+        {return REGISTRY_FILE;}
+    static int showThreads() noexcept
+        {return SHOW_THREADS;}
+    static int parseThreads() noexcept
+        {return PARSE_THREADS;}
+    static int serializeThreads() noexcept
+        {return SERIALIZE_THREADS;}
+    static int writeThreads() noexcept
+        {return WRITE_THREADS;}
+    static int queueCapacity() noexcept
+        {return QUEUE_CAPACITY;}
+    static bool pipelineMetrics() noexcept
+        {return PIPELINE_METRICS;}
+    static std::size_t pipelineMemoryBudget() noexcept
+        {return PIPELINE_MEMORY_BUDGET;}
+    static int shardInstance() noexcept
+        {return SHARD_INSTANCE;}
+    static int shardInstances() noexcept
+        {return SHARD_INSTANCES;}
+    static int shardVnodes() noexcept
+        {return SHARD_VNODES;}
+    static const std::filesystem::path &leaseDir() noexcept
+        {return LEASE_DIR;}
+    // directory of temporary files of this instance,
+    // so that instances on same host never use same path.
+    static std::filesystem::path tempDir()
+        {return std::filesystem::temp_directory_path() / ("collector-" + std::to_string(SHARD_INSTANCE));}
+    // seconds.
+    static long long leaseDuration() noexcept
+        {return LEASE_DURATION;}
+    static bool probe() noexcept
+        {return PROBE;}
+    static int probeThreads() noexcept
+        {return PROBE_THREADS;}
+    static int probeHostConcurrency() noexcept
+        {return PROBE_HOST_CONCURRENCY;}
+    static bool maintenance() noexcept
+        {return MAINTENANCE;}
+    static std::size_t maintenancePackThreshold() noexcept
+        {return MAINTENANCE_PACK_THRESHOLD;}
+    static std::size_t maintenanceLooseThreshold() noexcept
+        {return MAINTENANCE_LOOSE_THRESHOLD;}
+    // seconds.
+    static long long maintenanceInterval() noexcept
+        {return MAINTENANCE_INTERVAL;}
+    static bool maintenanceMetrics() noexcept
+        {return MAINTENANCE_METRICS;}
+    // use long-lived git processes in diff stage instead of spawning git per commit.
+    static bool coprocess() noexcept
+        {return COPROCESS;}
+    static const std::string &diffEngine() noexcept
+        {return DIFF_ENGINE;}
+    static std::size_t commitMemoryBudget() noexcept
+        {return COMMIT_MEMORY_BUDGET;}
+    static const std::string &oversizePolicy() noexcept
+        {return OVERSIZE_POLICY;}
+    static const std::vector<std::string> &logFields() noexcept
+        {return LOG_FIELDS;}
+    static bool logNumstat() noexcept
+        {return LOG_NUMSTAT;}
+    // empty if tracing is disabled.
+    static const std::filesystem::path &traceFile() noexcept
+        {return TRACE_FILE;}
 
 private:
     static bool loadConfigure();
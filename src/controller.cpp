@@ -1,10 +1,17 @@
 #include <iostream>
 #include <vector>
 #include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <chrono>
+#include <system_error>
+
+#include <boost/property_tree/json_parser.hpp>
 
 #include "git.hpp"
 #include "path.hpp"
+#include "shard.hpp"
+#include "trace.hpp"
 #include "configure.hpp"
 #include "controller.hpp"
 
@@ -29,6 +36,9 @@ bool Controller::initialize()
         return false;
     }
     
+    if(!Configure::traceFile().empty())
+        TRACE::enable();
+
     if(!loadFromDirectory())
     {
         std::cerr << "init error:\n"
@@ -45,10 +55,13 @@ void Controller::run()
     // while(process())
     //     std::this_thread::sleep_for(std::chrono::hours(Configure::loopRange()));
     process();
+    trace();
 }
 
 bool Controller::process()
 {
+    TRACE::Span span("controller", "process");
+
     if(!loadFromJson())
     {
         std::cerr << "load-repositories error:\n"
@@ -65,6 +78,14 @@ bool Controller::process()
         return false;
     }
 
+    if(!probe())
+    {
+        std::cerr << "probe-remote error:\n"
+            "    what: failed to probe remote refs.\n"
+            << std::flush;
+        return false;
+    }
+
     if(!pull())
     {
         std::cerr << "pull-branch error:\n"
@@ -73,6 +94,14 @@ bool Controller::process()
         return false;
     }
 
+    if(!maintain())
+    {
+        std::cerr << "maintain-repositories error:\n"
+            "    what: failed to maintain repositories.\n"
+            << std::flush;
+        return false;
+    }
+
     if(!log())
     {
         std::cerr << "get-log error:\n"
@@ -89,17 +118,60 @@ bool Controller::process()
         return false;
     }
 
+    if(!saveRegistry())
+    {
+        std::cerr << "save-registry warning:\n"
+            "    what: failed to save registry.\n"
+            "    file: " << Configure::registryFile().string() << "\n"
+            "    approach: read repositories directory at next startup.\n"
+            << std::flush;
+    }
+
+    return true;
+}
+
+bool Controller::trace() const
+{
+    if(!TRACE::isEnabled())
+        return true;
+
+    if(!TRACE::write(Configure::traceFile()))
+    {
+        std::cerr << "trace warning:\n"
+            "    what: failed to write trace file.\n"
+            "    file: " << Configure::traceFile().string() << "\n"
+            "    approach: retry at next cycle.\n"
+            << std::flush;
+    }
+
     return true;
 }
 
 bool Controller::loadFromJson()
 {
+    TRACE::Span span("controller", "loadFromJson");
+
+    SHARD::Ring ring(aliveInstances(), Configure::shardVnodes());
+
     if(!Configure::reloadRepositories())
     {
         std::cerr << "loadFromJson warning:\n"
             "    what: failed to load json file.\n"
             "    approach: use previous value.\n"
             << std::flush;
+
+        // alive instances may have changed, and previous value may come from loadFromDirectory(),
+        // so repositories of other instances are dropped also here.
+        for(auto iter = mRepositories.begin(); iter != mRepositories.end();)
+        {
+            if(ring.owner(iter->first) != Configure::shardInstance())
+            {
+                delete iter->second;
+                iter = mRepositories.erase(iter);
+            }
+            else
+                iter++;
+        }
         return true;
     }
 
@@ -107,6 +179,19 @@ bool Controller::loadFromJson()
     for(auto &&p : Configure::repositoriesMap())
     {
         auto iter = mRepositories.find(p.first);
+
+        // repository of other instance is not removed from directory,
+        // because it may return to this instance.
+        if(ring.owner(p.first) != Configure::shardInstance())
+        {
+            if(iter != mRepositories.end())
+            {
+                delete iter->second;
+                mRepositories.erase(iter);
+            }
+            continue;
+        }
+
         if(iter == mRepositories.end())
             newReps.emplace(p.first
                 , new GIT::Repository(Configure::repositoriesDir() / p.first
@@ -138,16 +223,81 @@ bool Controller::loadFromJson()
 
     mRepositories.merge(newReps);
 
+    for(auto &&p : mRepositories)
+        p.second->setRefs(Configure::repositoryRefs(p.first));
+
     return true;
 }
 
+std::vector<int> Controller::aliveInstances() const
+{
+    if(Configure::shardInstances() == 1)
+        return {Configure::shardInstance()};
+
+    renewLease();
+
+    // instance whose lease is expired or missing is regarded as disappeared,
+    // and its shard is shared by remaining instances.
+    std::vector<int> instances;
+    for(int i = 0; i < Configure::shardInstances(); i++)
+    {
+        if(i == Configure::shardInstance()
+            || SHARD::isAlive(Configure::leaseDir(), i, Configure::leaseDuration()))
+            instances.push_back(i);
+    }
+
+    return instances;
+}
+
+void Controller::renewLease() const
+{
+    if(Configure::shardInstances() == 1)
+        return;
+
+    if(!SHARD::renew(Configure::leaseDir(), Configure::shardInstance()))
+    {
+        std::cerr << "renew-lease warning:\n"
+            "    what: failed to renew lease.\n"
+            "    dir: " << Configure::leaseDir().string() << "\n"
+            "    instance: " << Configure::shardInstance() << "\n"
+            "    approach: other instances may take over this shard.\n"
+            << std::flush;
+    }
+}
+
 bool Controller::loadFromDirectory()
 {
     if(!PATH::isValid(Configure::repositoriesDir(), std::filesystem::file_type::directory))
         return false;
 
+    std::unordered_map<std::string, std::string> registry;
+    std::filesystem::file_time_type registryTime;
+    if(PATH::isExist(Configure::registryFile())
+        && !loadRegistry(registry, registryTime))
+    {
+        std::cerr << "load-registry warning:\n"
+            "    what: failed to load registry.\n"
+            "    file: " << Configure::registryFile().string() << "\n"
+            "    approach: read url from each repository.\n"
+            << std::flush;
+    }
+
     for(auto &&de : std::filesystem::directory_iterator(Configure::repositoriesDir()))
     {
+        std::string name(de.path().filename());
+
+        // registry entry is used if .git/config has not been changed since registry was written.
+        std::error_code ec;
+        if(auto iter = registry.find(name); iter != registry.end())
+        {
+            auto time = std::filesystem::last_write_time(de.path() / ".git" / "config", ec);
+            if(!ec && time <= registryTime)
+            {
+                mRepositories.emplace(name, new GIT::Repository(de.path(), iter->second));
+                continue;
+            }
+        }
+
         GIT::Repository rep(de.path(), std::string());
         if(!rep.setUrl())
         {
@@ -160,17 +310,88 @@ bool Controller::loadFromDirectory()
                 << std::flush;
         }
         else
-            mRepositories.emplace(de.path().filename(), new GIT::Repository(std::move(rep)));
+            mRepositories.emplace(name, new GIT::Repository(std::move(rep)));
     }
 
     return true;
 }
 
+bool Controller::loadRegistry(std::unordered_map<std::string, std::string> &registry
+    , std::filesystem::file_time_type &time) const
+{
+    using namespace boost::property_tree;
+
+    if(!PATH::isExist(Configure::registryFile()))
+        return false;
+
+    ptree tree;
+    std::error_code ec;
+    time = std::filesystem::last_write_time(Configure::registryFile(), ec);
+    if(ec)
+        return false;
+
+    try
+        {read_json(Configure::registryFile().string(), tree);}
+    catch(const std::exception &e)
+        {return false;}
+
+    auto optarr = tree.get_child_optional(REGISTRY_KEY);
+    if(!optarr)
+        return false;
+
+    for(auto &&c : optarr.get())
+    {
+        auto optname = c.second.get_optional<std::string>(REGISTRY_NAME_KEY);
+        auto opturl = c.second.get_optional<std::string>(REGISTRY_URL_KEY);
+        if(optname && opturl)
+            registry.emplace(optname.get(), opturl.get());
+    }
+
+    return true;
+}
+
+bool Controller::saveRegistry() const
+{
+    TRACE::Span span("controller", "saveRegistry");
+
+    using namespace boost::property_tree;
+
+    ptree arr;
+    for(auto &&p : mRepositories)
+    {
+        ptree ele;
+        ele.put(REGISTRY_NAME_KEY, p.first);
+        ele.put(REGISTRY_URL_KEY, p.second->url());
+        arr.push_back(std::make_pair("", ele));
+    }
+
+    ptree tree;
+    tree.add_child(REGISTRY_KEY, arr);
+
+    // registry is replaced at once, so that it is not read while it is written.
+    std::filesystem::path tmp(Configure::registryFile().string() + ".tmp");
+    if(!PATH::isValid(tmp))
+        return false;
+
+    try
+        {write_json(tmp.string(), tree);}
+    catch(const std::exception &e)
+        {return false;}
+
+    std::error_code ec;
+    std::filesystem::rename(tmp, Configure::registryFile(), ec);
+    return !ec;
+}
+
 bool Controller::clone()
 {
+    TRACE::Span span("controller", "clone");
+
     std::vector<std::string> rmvec;
     for(auto &&p : mRepositories)
     {
+        renewLease();
+
         if(!p.second->clone())
         {
             rmvec.push_back(p.first);
@@ -191,11 +412,70 @@ bool Controller::clone()
     return true;
 }
 
+bool Controller::probe()
+{
+    TRACE::Span span("controller", "probe");
+
+    if(!Configure::probe())
+        return true;
+
+    std::vector<GIT::Repository*> reps;
+    for(auto &&p : mRepositories)
+        reps.push_back(p.second);
+
+    // number of probes running for each host is limited to host_concurrency.
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::unordered_map<std::string, int> running;
+    std::size_t next = 0;
+
+    auto &&worker = [&]
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while(next < reps.size())
+            {
+                GIT::Repository *rep = reps[next++];
+                std::string host(rep->host());
+                cv.wait(lock, [&]{return running[host] < Configure::probeHostConcurrency();});
+                running[host]++;
+                lock.unlock();
+
+                if(!rep->probe())
+                {
+                    std::cerr << "probe warning:\n"
+                        "    what: failed to probe remote repository.\n"
+                        "    path: " << rep->path().string() << "\n"
+                        "    approach: regard this repository as changed.\n"
+                        << std::flush;
+                }
+
+                lock.lock();
+                running[host]--;
+                cv.notify_all();
+            }
+        };
+
+    std::vector<std::thread> threads;
+    for(int i = 0; i < Configure::probeThreads(); i++)
+        threads.emplace_back(worker);
+    for(auto &&t : threads)
+        t.join();
+
+    return true;
+}
+
 bool Controller::pull()
 {
+    TRACE::Span span("controller", "pull");
+
     std::vector<std::string> rmvec;
     for(auto &&p : mRepositories)
     {
+        if(!p.second->isChanged())
+            continue;
+
+        renewLease();
+
         if(!p.second->pull())
         {
             rmvec.push_back(p.first);
@@ -216,12 +496,47 @@ bool Controller::pull()
     return true;
 }
 
+bool Controller::maintain()
+{
+    TRACE::Span span("controller", "maintain");
+
+    if(!Configure::maintenance())
+        return true;
+
+    for(auto &&p : mRepositories)
+    {
+        if(!p.second->isChanged())
+            continue;
+
+        renewLease();
+
+        // repository is still readable if maintenance fails.
+        if(!p.second->maintain())
+        {
+            std::cerr << "maintain warning:\n"
+                "    what: failed to maintain repository.\n"
+                "    name: " << p.first << "\n"
+                "    approach: retry failed steps at next pull (repack after maintenance interval).\n"
+                << std::flush;
+        }
+    }
+
+    return true;
+}
+
 bool Controller::log()
 {
+    TRACE::Span span("controller", "log");
+
     std::vector<std::string> rmvec;
     for(auto &&p : mRepositories)
     {
-        if(!p.second->log(std::filesystem::temp_directory_path() / p.first))
+        if(!p.second->isChanged())
+            continue;
+
+        renewLease();
+
+        if(!p.second->log(Configure::tempDir() / p.first))
         {
             rmvec.push_back(p.first);
             p.second->remove(Configure::differenceDir() / p.first);
@@ -243,11 +558,19 @@ bool Controller::log()
 
 bool Controller::diff()
 {
+    TRACE::Span span("controller", "diff");
+
     std::vector<std::string> rmvec;
     for(auto &&p : mRepositories)
     {
-        if(!p.second->diff(std::filesystem::temp_directory_path() / p.first
-            , Configure::differenceDir() / p.first))
+        if(!p.second->isChanged())
+            continue;
+
+        renewLease();
+        std::size_t failed = 0;
+        if(!p.second->diff(Configure::tempDir() / p.first
+            , Configure::differenceDir() / p.first
+            , failed))
         {
             rmvec.push_back(p.first);
             p.second->remove(Configure::differenceDir() / p.first);
@@ -259,6 +582,25 @@ bool Controller::diff()
                 "    approach: remove this repository.\n"
                 << std::flush;
         }
+        else if(failed != 0)
+        {
+            // refs are not saved, so that probe regards repository as changed
+            // and failed commits are retried at next cycle.
+            std::cerr << "diff warning:\n"
+                "    what: failed to output some commits.\n"
+                "    name: " << p.first << "\n"
+                "    failed: " << failed << "\n"
+                "    approach: retry them at next cycle.\n"
+                << std::flush;
+        }
+        else if(!p.second->saveRefs())
+        {
+            std::cerr << "diff warning:\n"
+                "    what: failed to save remote refs.\n"
+                "    name: " << p.first << "\n"
+                "    approach: probe regards this repository as changed next time.\n"
+                << std::flush;
+        }
     }
 
     for(auto &&s : rmvec)
@@ -1,14 +1,19 @@
 #ifndef CONTROLLER_HPP
 #define CONTROLLER_HPP
 
+#include <filesystem>
 #include <unordered_map>
 #include <string>
+#include <vector>
 
 namespace GIT{class Repository;}
 
 class Controller
 {
 private:
+    inline static const std::string REGISTRY_KEY = "repositories";
+    inline static const std::string REGISTRY_NAME_KEY = "name";
+    inline static const std::string REGISTRY_URL_KEY = "url";
 
 public:
     Controller();
@@ -20,11 +25,25 @@ public:
 
 private:
     bool process();
+    // write events of cycle to trace_file if tracing is enabled.
+    bool trace() const;
 
     bool loadFromJson();
+    // this instance and instances whose lease is valid.
+    std::vector<int> aliveInstances() const;
+    // lease is renewed for each repository, so that cycle longer than
+    // lease_duration does not hand shard to other instance.
+    void renewLease() const;
     bool loadFromDirectory();
+    bool loadRegistry(std::unordered_map<std::string, std::string>&
+        , std::filesystem::file_time_type&) const;
+    bool saveRegistry() const;
     bool clone();
+    // skip pull, log and diff of repositories whose remote refs are not changed.
+    bool probe();
     bool pull();
+    // keep log and show of pulled repositories fast.
+    bool maintain();
     bool log();
     bool diff();
 
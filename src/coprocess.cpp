@@ -0,0 +1,297 @@
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include "trace.hpp"
+#include "coprocess.hpp"
+
+namespace COPROCESS
+{
+
+Process::Process(const std::vector<std::string> &argv)
+    : mArgv(argv)
+    , mPid(-1)
+    , mFd(-1)
+    , mBuffer()
+{
+}
+
+Process::~Process()
+{
+    stop();
+}
+
+bool Process::start()
+{
+    if(mPid > 0)
+        return true;
+
+    // arguments are prepared before fork, because child may only call async-signal-safe functions.
+    // command line is joined only for trace.
+    std::vector<char*> argv;
+    std::string command;
+    for(auto &&a : mArgv)
+    {
+        argv.push_back(const_cast<char*>(a.c_str()));
+        if(TRACE::isEnabled())
+            command += (command.empty() ? "" : " ") + a;
+    }
+    argv.push_back(nullptr);
+
+    TRACE::Span span("coprocess", "start", command);
+
+    // CLOEXEC keeps other children from holding parent end, which would hide EOF from child.
+    int fds[2];
+    if(socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0)
+        return false;
+
+    pid_t pid = fork();
+    if(pid < 0)
+    {
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+
+    if(pid == 0)
+    {
+        int null = open("/dev/null", O_WRONLY);
+        if(dup2(fds[1], STDIN_FILENO) < 0
+            || dup2(fds[1], STDOUT_FILENO) < 0
+            || (null >= 0 && dup2(null, STDERR_FILENO) < 0))
+            _exit(127);
+        execvp(argv[0], argv.data());
+        _exit(127);
+    }
+
+    close(fds[1]);
+    mPid = pid;
+    mFd = fds[0];
+    mBuffer.clear();
+    return true;
+}
+
+void Process::stop(bool force)
+{
+    if(mPid <= 0)
+        return;
+
+    if(force)
+        kill(mPid, SIGKILL);
+
+    shutdown(mFd, SHUT_WR);
+    close(mFd);
+    while(waitpid(mPid, nullptr, 0) < 0 && errno == EINTR);
+
+    mPid = -1;
+    mFd = -1;
+    mBuffer.clear();
+}
+
+bool Process::isAlive()
+{
+    if(mPid <= 0)
+        return false;
+
+    int status;
+    pid_t ret = waitpid(mPid, &status, WNOHANG);
+    if(ret == 0)
+        return true;
+
+    // child has exited and is reaped.
+    close(mFd);
+    mPid = -1;
+    mFd = -1;
+    mBuffer.clear();
+    return false;
+}
+
+bool Process::write(const std::string &data)
+{
+    if(mPid <= 0)
+        return false;
+
+    for(std::size_t pos = 0; pos < data.size();)
+    {
+        ssize_t n = send(mFd, data.data() + pos, data.size() - pos, MSG_NOSIGNAL);
+        if(n < 0)
+        {
+            if(errno == EINTR)
+                continue;
+            return false;
+        }
+        pos += static_cast<std::size_t>(n);
+    }
+
+    return true;
+}
+
+bool Process::readLine(std::string &line)
+{
+    for(std::size_t from = 0;;)
+    {
+        if(std::string::size_type pos = mBuffer.find('\n', from); pos != std::string::npos)
+        {
+            line.assign(mBuffer, 0, pos);
+            mBuffer.erase(0, pos + 1);
+            return true;
+        }
+
+        from = mBuffer.size();
+        if(!fill())
+            return false;
+    }
+}
+
+bool Process::read(std::size_t size
+    , std::ostream &ostr)
+{
+    for(;;)
+    {
+        std::size_t n = std::min(size, mBuffer.size());
+        ostr.write(mBuffer.data(), static_cast<std::streamsize>(n));
+        mBuffer.erase(0, n);
+        size -= n;
+        if(size == 0)
+            return static_cast<bool>(ostr);
+
+        if(!fill())
+            return false;
+    }
+}
+
+bool Process::skip(std::size_t size)
+{
+    for(;;)
+    {
+        std::size_t n = std::min(size, mBuffer.size());
+        mBuffer.erase(0, n);
+        size -= n;
+        if(size == 0)
+            return true;
+
+        if(!fill())
+            return false;
+    }
+}
+
+bool Process::readUntil(const std::string &terminator
+    , std::ostream &ostr)
+{
+    std::string line(terminator + "\n");
+    bool isBeginning = true;
+    for(;;)
+    {
+        for(std::string::size_type pos = mBuffer.find(line)
+            ; pos != std::string::npos
+            ; pos = mBuffer.find(line, pos + 1))
+        {
+            if(pos == 0
+                ? isBeginning
+                    : mBuffer[pos - 1] == '\n' || mBuffer[pos - 1] == '\0')
+            {
+                ostr.write(mBuffer.data(), static_cast<std::streamsize>(pos));
+                mBuffer.erase(0, pos + line.size());
+                return static_cast<bool>(ostr);
+            }
+        }
+
+        // output is passed to ostr except tail that may be part of terminator
+        // and one byte before it, so that memory does not grow with size of response.
+        if(mBuffer.size() > line.size() + 1)
+        {
+            std::size_t size = mBuffer.size() - line.size() - 1;
+            ostr.write(mBuffer.data(), static_cast<std::streamsize>(size));
+            mBuffer.erase(0, size);
+            isBeginning = false;
+        }
+
+        if(!fill())
+            return false;
+    }
+}
+
+bool Process::fill()
+{
+    if(mPid <= 0)
+        return false;
+
+    char buf[CHUNK_SIZE];
+    for(;;)
+    {
+        ssize_t n = recv(mFd, buf, sizeof(buf), 0);
+        if(n > 0)
+        {
+            mBuffer.append(buf, static_cast<std::size_t>(n));
+            return true;
+        }
+        if(n < 0 && errno == EINTR)
+            continue;
+        return false;
+    }
+}
+
+Pool::Lease::~Lease()
+{
+    if(mPool)
+        mPool->release(mIndex, mIsFailed);
+}
+
+Pool::Pool(const std::vector<std::string> &argv
+    , std::size_t size)
+    : mMutex()
+    , mFree()
+    , mProcesses()
+    , mIsBusy(size != 0 ? size : 1, false)
+{
+    for(std::size_t i = 0; i < mIsBusy.size(); i++)
+        mProcesses.push_back(std::make_unique<Process>(argv));
+}
+
+Pool::Lease Pool::acquire()
+{
+    std::size_t index = 0;
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mFree.wait(lock, [&]
+            {
+                for(index = 0; index < mIsBusy.size(); index++)
+                {
+                    if(!mIsBusy[index])
+                        return true;
+                }
+                return false;
+            });
+        mIsBusy[index] = true;
+    }
+
+    // health check: process that has exited is started again.
+    Process &p = *mProcesses[index];
+    if(!p.isAlive() && !p.start())
+    {
+        release(index, false);
+        return Lease(nullptr, 0);
+    }
+
+    return Lease(this, index);
+}
+
+void Pool::release(std::size_t index
+    , bool isFailed)
+{
+    if(isFailed)
+        mProcesses[index]->stop(true);
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mIsBusy[index] = false;
+    }
+    mFree.notify_one();
+}
+
+}
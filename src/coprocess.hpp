@@ -0,0 +1,119 @@
+#ifndef COPROCESS_HPP
+#define COPROCESS_HPP
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+
+#include <sys/types.h>
+
+namespace COPROCESS
+{
+
+/* long-lived child process that is fed requests over stdin and answers over stdout.
+// stdin and stdout of child are one unix socket, so that writing to exited child
+// fails with EPIPE instead of SIGPIPE. stderr of child is /dev/null.
+*/
+class Process
+{
+public:
+    explicit Process(const std::vector<std::string> &argv);
+    ~Process();
+
+    Process(const Process&) = delete;
+    Process &operator=(const Process&) = delete;
+
+    bool start();
+    // close stdin of child and wait for it. child is killed if force is true.
+    void stop(bool force = false);
+    bool isAlive();
+
+    bool write(const std::string &data);
+    // line without '\n'.
+    bool readLine(std::string &line);
+    // copy size bytes to ostr in chunks, so that memory does not grow with size.
+    bool read(std::size_t size
+        , std::ostream &ostr);
+    // discard size bytes.
+    bool skip(std::size_t size);
+    /* copy output to ostr until line that equals terminator.
+    // terminator is recognized at beginning of response or after '\n' or '\0',
+    // so that it can frame both text and -z output.
+    */
+    bool readUntil(const std::string &terminator
+        , std::ostream &ostr);
+
+private:
+    bool fill();
+
+    inline static const std::size_t CHUNK_SIZE = 64 * 1024;
+
+    std::vector<std::string> mArgv;
+    pid_t mPid;
+    int mFd;
+    std::string mBuffer;
+};
+
+/* fixed number of processes running same command.
+// acquire() waits for free process, and (re)starts it if it is not alive.
+// if caller finds broken response, it calls Lease::fail(),
+// and process is stopped and restarted at next acquire().
+*/
+class Pool
+{
+public:
+    class Lease
+    {
+    public:
+        Lease(Pool *pool
+            , std::size_t index)
+            : mPool(pool)
+            , mIndex(index)
+            , mIsFailed(false){}
+        Lease(Lease &&other) noexcept
+            : mPool(other.mPool)
+            , mIndex(other.mIndex)
+            , mIsFailed(other.mIsFailed)
+            {other.mPool = nullptr;}
+        ~Lease();
+
+        Lease(const Lease&) = delete;
+        Lease &operator=(const Lease&) = delete;
+
+        explicit operator bool() const noexcept
+            {return mPool != nullptr;}
+        Process *operator->() const
+            {return mPool->mProcesses[mIndex].get();}
+
+        void fail() noexcept
+            {mIsFailed = true;}
+
+    private:
+        Pool *mPool;
+        std::size_t mIndex;
+        bool mIsFailed;
+    };
+
+    Pool(const std::vector<std::string> &argv
+        , std::size_t size);
+
+    // empty lease if process cannot be started.
+    Lease acquire();
+
+private:
+    void release(std::size_t index
+        , bool isFailed);
+
+    std::mutex mMutex;
+    std::condition_variable mFree;
+    std::vector<std::unique_ptr<Process>> mProcesses;
+    std::vector<bool> mIsBusy;
+};
+
+}
+
+#endif
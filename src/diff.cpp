@@ -0,0 +1,680 @@
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <emmintrin.h>
+#define DIFF_X86
+#endif
+
+#include "diff.hpp"
+
+namespace DIFF
+{
+
+namespace
+{
+
+constexpr int MAX_INDENT = 200;
+
+inline bool isSpace(char c) noexcept
+{
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+#ifdef DIFF_X86
+// bit of mask is set for each whitespace (' ', '\t', '\n', '\v', '\f', '\r').
+inline unsigned int spaceMask(const char *data) noexcept
+{
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+    __m128i t = _mm_sub_epi8(v, _mm_set1_epi8('\t'));
+    __m128i isCtrl = _mm_cmpeq_epi8(_mm_min_epu8(t, _mm_set1_epi8('\r' - '\t')), t);
+    __m128i isSp = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+    return _mm_movemask_epi8(_mm_or_si128(isCtrl, isSp));
+}
+#endif
+
+// file of xdiff. ids and indents are indexed by line,
+// changed has sentinels before first line and after last line.
+struct Side
+{
+    const std::vector<std::uint32_t> &ids;
+    const std::vector<int> &indents;
+    std::vector<char> changed;
+    // lines not discarded before Myers' algorithm.
+    std::vector<std::uint32_t> reduced;
+    std::vector<long> rindex;
+
+    Side(const std::vector<std::uint32_t> &i
+        , const std::vector<int> &in)
+        : ids(i)
+        , indents(in)
+        , changed(i.size() + 2, 0)
+        , reduced()
+        , rindex(){}
+
+    long size() const noexcept
+        {return static_cast<long>(ids.size());}
+    char &rchg(long i) noexcept
+        {return changed[i + 1];}
+};
+
+/* split point of middle snake.
+// see "An O(ND) Difference Algorithm and Its Variations".
+// diagonal k is i1 - i2. order of search and tie-breaks are same as xdiff,
+// because they decide which of equally short scripts is chosen.
+*/
+void split(const std::uint32_t *ha1
+    , long off1
+    , long lim1
+    , const std::uint32_t *ha2
+    , long off2
+    , long lim2
+    , long *kvdf
+    , long *kvdb
+    , long &si1
+    , long &si2)
+{
+    const long dmin = off1 - lim2, dmax = lim1 - off2;
+    const long fmid = off1 - off2, bmid = lim1 - lim2;
+    const bool isOdd = ((fmid - bmid) & 1) != 0;
+    long fmin = fmid, fmax = fmid;
+    long bmin = bmid, bmax = bmid;
+
+    kvdf[fmid] = off1;
+    kvdb[bmid] = lim1;
+
+    for(;;)
+    {
+        if(fmin > dmin)
+            kvdf[--fmin - 1] = -1;
+        else
+            ++fmin;
+        if(fmax < dmax)
+            kvdf[++fmax + 1] = -1;
+        else
+            --fmax;
+
+        for(long d = fmax; d >= fmin; d -= 2)
+        {
+            long i1 = kvdf[d - 1] >= kvdf[d + 1]
+                ? kvdf[d - 1] + 1
+                    : kvdf[d + 1];
+            long i2 = i1 - d;
+            for(; i1 < lim1 && i2 < lim2 && ha1[i1] == ha2[i2]; i1++, i2++);
+            kvdf[d] = i1;
+
+            if(isOdd && bmin <= d && d <= bmax && kvdb[d] <= i1)
+            {
+                si1 = i1;
+                si2 = i2;
+                return;
+            }
+        }
+
+        if(bmin > dmin)
+            kvdb[--bmin - 1] = std::numeric_limits<long>::max();
+        else
+            ++bmin;
+        if(bmax < dmax)
+            kvdb[++bmax + 1] = std::numeric_limits<long>::max();
+        else
+            --bmax;
+
+        for(long d = bmax; d >= bmin; d -= 2)
+        {
+            long i1 = kvdb[d - 1] < kvdb[d + 1]
+                ? kvdb[d - 1]
+                    : kvdb[d + 1] - 1;
+            long i2 = i1 - d;
+            for(; i1 > off1 && i2 > off2 && ha1[i1 - 1] == ha2[i2 - 1]; i1--, i2--);
+            kvdb[d] = i1;
+
+            if(!isOdd && fmin <= d && d <= fmax && i1 <= kvdf[d])
+            {
+                si1 = i1;
+                si2 = i2;
+                return;
+            }
+        }
+    }
+}
+
+void compare(Side &s1
+    , long off1
+    , long lim1
+    , Side &s2
+    , long off2
+    , long lim2
+    , long *kvdf
+    , long *kvdb)
+{
+    const std::uint32_t *ha1 = s1.reduced.data();
+    const std::uint32_t *ha2 = s2.reduced.data();
+
+    for(; off1 < lim1 && off2 < lim2 && ha1[off1] == ha2[off2]; off1++, off2++);
+    for(; off1 < lim1 && off2 < lim2 && ha1[lim1 - 1] == ha2[lim2 - 1]; lim1--, lim2--);
+
+    if(off1 == lim1)
+    {
+        for(; off2 < lim2; off2++)
+            s2.rchg(s2.rindex[off2]) = 1;
+    }
+    else if(off2 == lim2)
+    {
+        for(; off1 < lim1; off1++)
+            s1.rchg(s1.rindex[off1]) = 1;
+    }
+    else
+    {
+        long si1 = 0, si2 = 0;
+        split(ha1, off1, lim1, ha2, off2, lim2, kvdf, kvdb, si1, si2);
+        compare(s1, off1, si1, s2, off2, si2, kvdf, kvdb);
+        compare(s1, si1, lim1, s2, si2, lim2, kvdf, kvdb);
+    }
+}
+
+constexpr long MAX_EQUAL_LIMIT = 1024;
+constexpr long SIMILAR_SCAN_WINDOW = 100;
+constexpr long KEEP_DISCARD_RUN = 4;
+
+// 2 for line that has many matches, 1 for line that has some matches, 0 otherwise.
+bool isDiscardable(const std::vector<char> &dis
+    , long i
+    , long s
+    , long e)
+{
+    if(i - s > SIMILAR_SCAN_WINDOW)
+        s = i - SIMILAR_SCAN_WINDOW;
+    if(e - i > SIMILAR_SCAN_WINDOW)
+        e = i + SIMILAR_SCAN_WINDOW;
+
+    long rdis0 = 0, rpdis0 = 1;
+    for(long r = 1; i - r >= s; r++)
+    {
+        if(dis[i - r] == 0)
+            rdis0++;
+        else if(dis[i - r] == 2)
+            rpdis0++;
+        else
+            break;
+    }
+    if(rdis0 == 0)
+        return false;
+
+    long rdis1 = 0, rpdis1 = 1;
+    for(long r = 1; i + r <= e; r++)
+    {
+        if(dis[i + r] == 0)
+            rdis1++;
+        else if(dis[i + r] == 2)
+            rpdis1++;
+        else
+            break;
+    }
+    if(rdis1 == 0)
+        return false;
+
+    rdis1 += rdis0;
+    rpdis1 += rpdis0;
+    return rpdis1 * KEEP_DISCARD_RUN < rpdis1 + rdis1;
+}
+
+// choose lines of [dstart, dend) passed to Myers' algorithm.
+void reduce(Side &s
+    , long dstart
+    , long dend
+    , const std::unordered_map<std::uint32_t, long> &others)
+{
+    long limit = 1;
+    for(long n = s.size(); n > 0; n >>= 2)
+        limit <<= 1;
+    limit = std::min(limit, MAX_EQUAL_LIMIT);
+
+    std::vector<char> dis(s.size() + 1, 0);
+    for(long i = dstart; i < dend; i++)
+    {
+        auto iter = others.find(s.ids[i]);
+        long count = iter != others.end() ? iter->second : 0;
+        dis[i] = count == 0 ? 0 : count >= limit ? 2 : 1;
+    }
+
+    for(long i = dstart; i < dend; i++)
+    {
+        if(dis[i] == 1
+            || (dis[i] == 2 && !isDiscardable(dis, i, dstart, dend - 1)))
+        {
+            s.rindex.push_back(i);
+            s.reduced.push_back(s.ids[i]);
+        }
+        else
+            s.rchg(i) = 1;
+    }
+}
+
+// group of consecutive changed lines [start, end).
+struct Group
+{
+    long start;
+    long end;
+};
+
+void initGroup(Side &s
+    , Group &g)
+{
+    g.start = g.end = 0;
+    while(s.rchg(g.end))
+        g.end++;
+}
+
+bool nextGroup(Side &s
+    , Group &g)
+{
+    if(g.end == s.size())
+        return false;
+
+    g.start = g.end + 1;
+    for(g.end = g.start; s.rchg(g.end); g.end++);
+    return true;
+}
+
+bool previousGroup(Side &s
+    , Group &g)
+{
+    if(g.start == 0)
+        return false;
+
+    g.end = g.start - 1;
+    for(g.start = g.end; s.rchg(g.start - 1); g.start--);
+    return true;
+}
+
+bool slideDown(Side &s
+    , Group &g)
+{
+    if(g.end < s.size() && s.ids[g.start] == s.ids[g.end])
+    {
+        s.rchg(g.start++) = 0;
+        s.rchg(g.end++) = 1;
+        while(s.rchg(g.end))
+            g.end++;
+        return true;
+    }
+
+    return false;
+}
+
+bool slideUp(Side &s
+    , Group &g)
+{
+    if(g.start > 0 && s.ids[g.start - 1] == s.ids[g.end - 1])
+    {
+        s.rchg(--g.start) = 1;
+        s.rchg(--g.end) = 0;
+        while(s.rchg(g.start - 1))
+            g.start--;
+        return true;
+    }
+
+    return false;
+}
+
+// constants of indent heuristic of git.
+constexpr int MAX_BLANKS = 20;
+constexpr int START_OF_FILE_PENALTY = 1;
+constexpr int END_OF_FILE_PENALTY = 21;
+constexpr int TOTAL_BLANK_WEIGHT = -30;
+constexpr int POST_BLANK_WEIGHT = 6;
+constexpr int RELATIVE_INDENT_PENALTY = -4;
+constexpr int RELATIVE_INDENT_WITH_BLANK_PENALTY = 10;
+constexpr int RELATIVE_OUTDENT_PENALTY = 24;
+constexpr int RELATIVE_OUTDENT_WITH_BLANK_PENALTY = 17;
+constexpr int RELATIVE_DEDENT_PENALTY = 23;
+constexpr int RELATIVE_DEDENT_WITH_BLANK_PENALTY = 17;
+constexpr int INDENT_WEIGHT = 60;
+constexpr long INDENT_HEURISTIC_MAX_SLIDING = 100;
+
+struct Score
+{
+    int effectiveIndent = 0;
+    int penalty = 0;
+};
+
+// add badness of splitting file just before line at index split.
+void addSplitScore(const Side &s
+    , long split
+    , Score &score)
+{
+    bool isEnd = split >= s.size();
+    int indent = isEnd ? -1 : s.indents[split];
+
+    int preBlank = 0, preIndent = -1;
+    for(long i = split - 1; i >= 0; i--)
+    {
+        preIndent = s.indents[i];
+        if(preIndent != -1)
+            break;
+        if(++preBlank == MAX_BLANKS)
+        {
+            preIndent = 0;
+            break;
+        }
+    }
+
+    int postBlank = 0, postIndent = -1;
+    for(long i = split + 1; i < s.size(); i++)
+    {
+        postIndent = s.indents[i];
+        if(postIndent != -1)
+            break;
+        if(++postBlank == MAX_BLANKS)
+        {
+            postIndent = 0;
+            break;
+        }
+    }
+
+    if(preIndent == -1 && preBlank == 0)
+        score.penalty += START_OF_FILE_PENALTY;
+    if(isEnd)
+        score.penalty += END_OF_FILE_PENALTY;
+
+    int post = indent == -1 ? 1 + postBlank : 0;
+    int total = preBlank + post;
+    score.penalty += TOTAL_BLANK_WEIGHT * total;
+    score.penalty += POST_BLANK_WEIGHT * post;
+
+    int effective = indent != -1 ? indent : postIndent;
+    bool hasBlank = total != 0;
+    score.effectiveIndent += effective;
+
+    if(effective == -1 || preIndent == -1 || effective == preIndent)
+        ;
+    else if(effective > preIndent)
+        score.penalty += hasBlank ? RELATIVE_INDENT_WITH_BLANK_PENALTY : RELATIVE_INDENT_PENALTY;
+    else if(postIndent != -1 && postIndent > effective)
+        score.penalty += hasBlank ? RELATIVE_OUTDENT_WITH_BLANK_PENALTY : RELATIVE_OUTDENT_PENALTY;
+    else
+        score.penalty += hasBlank ? RELATIVE_DEDENT_WITH_BLANK_PENALTY : RELATIVE_DEDENT_PENALTY;
+}
+
+int compareScore(const Score &s1
+    , const Score &s2)
+{
+    int cmp = (s1.effectiveIndent > s2.effectiveIndent) - (s1.effectiveIndent < s2.effectiveIndent);
+    return INDENT_WEIGHT * cmp + (s1.penalty - s2.penalty);
+}
+
+/* move each group of changes in s to position git would choose.
+// group is slid up and down as far as possible (merging groups it bumps into),
+// and then aligned with group of other file if possible,
+// otherwise placed by indent heuristic.
+*/
+void compact(Side &s
+    , Side &o)
+{
+    Group g, go;
+    initGroup(s, g);
+    initGroup(o, go);
+
+    for(;;)
+    {
+        if(g.end != g.start)
+        {
+            long size, earliestEnd, endMatchingOther;
+            do
+            {
+                size = g.end - g.start;
+                endMatchingOther = -1;
+
+                while(slideUp(s, g))
+                    previousGroup(o, go);
+
+                earliestEnd = g.end;
+                if(go.end > go.start)
+                    endMatchingOther = g.end;
+
+                while(slideDown(s, g))
+                {
+                    nextGroup(o, go);
+                    if(go.end > go.start)
+                        endMatchingOther = g.end;
+                }
+            }
+            while(size != g.end - g.start);
+
+            if(g.end == earliestEnd)
+                ;
+            else if(endMatchingOther != -1)
+            {
+                while(go.end == go.start)
+                {
+                    slideUp(s, g);
+                    previousGroup(o, go);
+                }
+            }
+            else
+            {
+                long shift = earliestEnd;
+                if(g.end - size - 1 > shift)
+                    shift = g.end - size - 1;
+                if(g.end - INDENT_HEURISTIC_MAX_SLIDING > shift)
+                    shift = g.end - INDENT_HEURISTIC_MAX_SLIDING;
+
+                long bestShift = -1;
+                Score best;
+                for(; shift <= g.end; shift++)
+                {
+                    Score score;
+                    addSplitScore(s, shift, score);
+                    addSplitScore(s, shift - size, score);
+                    if(bestShift == -1 || compareScore(score, best) <= 0)
+                    {
+                        best = score;
+                        bestShift = shift;
+                    }
+                }
+
+                while(g.end > bestShift)
+                {
+                    slideUp(s, g);
+                    previousGroup(o, go);
+                }
+            }
+        }
+
+        if(!nextGroup(s, g))
+            break;
+        nextGroup(o, go);
+    }
+}
+
+}
+
+void fold(const char *data
+    , std::size_t size
+    , std::string &dst)
+{
+    dst.clear();
+
+    bool isPending = false;
+    std::size_t pos = 0;
+#ifdef DIFF_X86
+    // block without whitespace is copied at once.
+    for(; pos + 16 <= size; pos += 16)
+    {
+        unsigned int mask = spaceMask(data + pos);
+        if(mask == 0)
+        {
+            if(isPending)
+                dst.push_back(' ');
+            isPending = false;
+            dst.append(data + pos, 16);
+            continue;
+        }
+
+        for(std::size_t i = 0; i < 16; i++)
+        {
+            if(mask & (1u << i))
+                isPending = true;
+            else
+            {
+                if(isPending)
+                    dst.push_back(' ');
+                isPending = false;
+                dst.push_back(data[pos + i]);
+            }
+        }
+    }
+#endif
+
+    for(; pos < size; pos++)
+    {
+        if(isSpace(data[pos]))
+            isPending = true;
+        else
+        {
+            if(isPending)
+                dst.push_back(' ');
+            isPending = false;
+            dst.push_back(data[pos]);
+        }
+    }
+}
+
+bool isBlank(const char *data
+    , std::size_t size) noexcept
+{
+    std::size_t pos = 0;
+#ifdef DIFF_X86
+    for(; pos + 16 <= size; pos += 16)
+    {
+        if(spaceMask(data + pos) != 0xffff)
+            return false;
+    }
+#endif
+
+    for(; pos < size; pos++)
+    {
+        if(!isSpace(data[pos]))
+            return false;
+    }
+
+    return true;
+}
+
+bool isBinary(const std::string &blob) noexcept
+{
+    return blob.find('\0') < 8000;
+}
+
+std::size_t commonTail(const std::string &a
+    , const std::string &b) noexcept
+{
+    const std::size_t BLOCK = 1024;
+    std::size_t smaller = std::min(a.size(), b.size());
+    std::size_t trimmed = 0;
+    while(trimmed + BLOCK <= smaller
+        && std::memcmp(a.data() + a.size() - trimmed - BLOCK
+            , b.data() + b.size() - trimmed - BLOCK
+            , BLOCK) == 0)
+        trimmed += BLOCK;
+
+    const char *rest = a.data() + a.size() - trimmed;
+    std::size_t recovered = 0;
+    while(recovered < trimmed)
+    {
+        if(rest[recovered++] == '\n')
+            break;
+    }
+    return trimmed - recovered;
+}
+
+std::uint32_t Classifier::id(const char *data
+    , std::size_t size)
+{
+    fold(data, size, mBuffer);
+    return mIds.emplace(mBuffer, static_cast<std::uint32_t>(mIds.size())).first->second;
+}
+
+int indent(const char *data
+    , std::size_t size) noexcept
+{
+    int ret = 0;
+    for(std::size_t i = 0; i < size; i++)
+    {
+        char c = data[i];
+        if(!isSpace(c))
+            return ret;
+        else if(c == ' ')
+            ret += 1;
+        else if(c == '\t')
+            ret += 8 - ret % 8;
+
+        if(ret >= MAX_INDENT)
+            return MAX_INDENT;
+    }
+
+    return -1;
+}
+
+std::vector<Change> diff(const std::vector<std::uint32_t> &a
+    , const std::vector<int> &aindents
+    , const std::vector<std::uint32_t> &b
+    , const std::vector<int> &bindents)
+{
+    Side s1(a, aindents), s2(b, bindents);
+    const long n = s1.size(), m = s2.size();
+
+    // common lines at both ends are not changed.
+    long dstart = 0;
+    for(long lim = std::min(n, m); dstart < lim && a[dstart] == b[dstart]; dstart++);
+    long tail = 0;
+    for(long lim = std::min(n, m) - dstart; tail < lim && a[n - 1 - tail] == b[m - 1 - tail]; tail++);
+
+    // line that does not appear in other file is changed without search.
+    // line that appears many times is also changed
+    // if it is surrounded mostly by such lines.
+    std::unordered_map<std::uint32_t, long> counts1, counts2;
+    for(auto id : a)
+        counts1[id]++;
+    for(auto id : b)
+        counts2[id]++;
+    reduce(s1, dstart, n - tail, counts2);
+    reduce(s2, dstart, m - tail, counts1);
+
+    const long n1 = static_cast<long>(s1.reduced.size());
+    const long n2 = static_cast<long>(s2.reduced.size());
+    std::vector<long> kvd(2 * (n1 + n2 + 3));
+    compare(s1, 0, n1, s2, 0, n2
+        , kvd.data() + n2 + 1
+        , kvd.data() + n2 + 1 + (n1 + n2 + 3));
+
+    compact(s1, s2);
+    compact(s2, s1);
+
+    std::vector<Change> changes;
+    for(long i = 0, j = 0; i < n || j < m;)
+    {
+        if(i < n && j < m && !s1.rchg(i) && !s2.rchg(j))
+        {
+            i++, j++;
+            continue;
+        }
+
+        Change c{static_cast<std::size_t>(i), 0, static_cast<std::size_t>(j), 0};
+        while(i < n && s1.rchg(i))
+            i++;
+        while(j < m && s2.rchg(j))
+            j++;
+        c.count1 = i - c.first1;
+        c.count2 = j - c.first2;
+        if(c.count1 == 0 && c.count2 == 0)
+            break;
+        changes.push_back(c);
+    }
+
+    return changes;
+}
+
+}
@@ -0,0 +1,86 @@
+#ifndef DIFF_HPP
+#define DIFF_HPP
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+
+namespace DIFF
+{
+
+/* range of changed lines.
+// old[first1, first1 + count1) is replaced by new[first2, first2 + count2).
+// indices are 0-based.
+*/
+struct Change
+{
+    std::size_t first1;
+    std::size_t count1;
+    std::size_t first2;
+    std::size_t count2;
+};
+
+/* line equivalence of git diff --ignore-space-change.
+// each run of whitespace is folded into one space,
+// and whitespace at end of line is removed.
+// lines are equal if their folded strings are equal.
+*/
+extern void fold(const char *data
+    , std::size_t size
+    , std::string &dst);
+
+// true if line has only whitespace.
+extern bool isBlank(const char *data
+    , std::size_t size) noexcept;
+
+// same heuristic as git: NUL in first 8000 bytes.
+extern bool isBinary(const std::string &blob) noexcept;
+
+/* size of common tail that git diff drops before diff when unified context is 0.
+// tail is compared in 1024-byte blocks and given back up to first '\n',
+// so result depends on bytes and not on lines. it changes which lines
+// are counted as frequent, so output is same as git only if this is applied.
+*/
+extern std::size_t commonTail(const std::string &a
+    , const std::string &b) noexcept;
+
+/* assign same id to equivalent lines.
+// ids are shared between old and new blobs of one file.
+*/
+class Classifier
+{
+public:
+    Classifier()
+        : mIds()
+        , mBuffer(){}
+
+    std::uint32_t id(const char *data
+        , std::size_t size);
+
+private:
+    std::unordered_map<std::string, std::uint32_t> mIds;
+    std::string mBuffer;
+};
+
+/* width of leading whitespace ('\t' is counted to next multiple of 8).
+// if line has only whitespace, function returns -1.
+// this is used to place ambiguous changes by indent heuristic.
+*/
+extern int indent(const char *data
+    , std::size_t size) noexcept;
+
+/* minimal edit script between a and b (ids of Classifier) by same steps as git diff --minimal.
+// common lines at both ends and lines that do not appear in other file are changed first,
+// Myers' O(ND) algorithm (linear space version) is applied to remaining lines,
+// and ambiguous changes are placed by indent heuristic.
+*/
+extern std::vector<Change> diff(const std::vector<std::uint32_t> &a
+    , const std::vector<int> &aindents
+    , const std::vector<std::uint32_t> &b
+    , const std::vector<int> &bindents);
+
+}
+
+#endif
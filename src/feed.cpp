@@ -0,0 +1,268 @@
+#include <utility>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+
+#include "path.hpp"
+#include "feed.hpp"
+
+namespace FEED
+{
+
+namespace
+{
+
+bool parse(const std::string &line
+    , Entry &entry)
+{
+    std::string::size_type p1 = line.find('\t');
+    std::string::size_type p2 = p1 != std::string::npos ? line.find('\t', p1 + 1) : std::string::npos;
+    std::string::size_type p3 = p2 != std::string::npos ? line.find('\t', p2 + 1) : std::string::npos;
+    if(p3 == std::string::npos)
+        return false;
+
+    try
+        {entry.seq = std::stoull(line.substr(0, p1));}
+    catch(const std::exception &e)
+        {return false;}
+
+    entry.repository = line.substr(p1 + 1, p2 - p1 - 1);
+    entry.hash = line.substr(p2 + 1, p3 - p2 - 1);
+    entry.location = line.substr(p3 + 1);
+    return true;
+}
+
+// exclusive flock during lifetime.
+class Lock
+{
+public:
+    explicit Lock(int fd)
+        : mFd(fd)
+        , mIsLocked(false)
+    {
+        while(!(mIsLocked = flock(mFd, LOCK_EX) == 0) && errno == EINTR);
+    }
+    ~Lock()
+    {
+        if(mIsLocked)
+            flock(mFd, LOCK_UN);
+    }
+
+    Lock(const Lock&) = delete;
+    Lock &operator=(const Lock&) = delete;
+
+    explicit operator bool() const noexcept
+        {return mIsLocked;}
+
+private:
+    int mFd;
+    bool mIsLocked;
+};
+
+}
+
+Writer::Writer()
+    : mMutex()
+    , mFd(-1)
+    , mSeq(0)
+    , mSize(0)
+{
+}
+
+Writer::~Writer()
+{
+    if(mFd >= 0)
+        close(mFd);
+}
+
+bool Writer::open(const std::filesystem::path &file)
+{
+    if(!PATH::isValid(file))
+        return false;
+
+    if(mFd >= 0)
+        close(mFd);
+    mFd = ::open(file.c_str(), O_RDWR | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+    if(mFd < 0)
+        return false;
+
+    Lock lock(mFd);
+    if(lock && readTail())
+        return true;
+
+    close(mFd);
+    mFd = -1;
+    return false;
+}
+
+bool Writer::append(const std::string &repository
+    , const std::string &hash
+    , const std::string &location)
+{
+    std::lock_guard<std::mutex> guard(mMutex);
+    if(mFd < 0)
+        return false;
+
+    Lock lock(mFd);
+    if(!lock)
+        return false;
+
+    // tail is read again only if other writer has appended since last write.
+    struct stat st;
+    if(fstat(mFd, &st) != 0)
+        return false;
+    if(static_cast<std::uint64_t>(st.st_size) != mSize
+        && !readTail())
+        return false;
+
+    // line is written by one write(2), so that consumers never see it half-written
+    // unless disk is full.
+    std::string line(std::to_string(mSeq + 1) + '\t' + repository + '\t' + hash + '\t' + location + '\n');
+    for(std::size_t pos = 0; pos < line.size();)
+    {
+        ssize_t n = write(mFd, line.data() + pos, line.size() - pos);
+        if(n < 0)
+        {
+            if(errno == EINTR)
+                continue;
+            return false;
+        }
+        pos += static_cast<std::size_t>(n);
+    }
+
+    mSeq++;
+    mSize += line.size();
+    return true;
+}
+
+bool Writer::readTail()
+{
+    struct stat st;
+    if(fstat(mFd, &st) != 0)
+        return false;
+
+    // only tail of file is read, because lines are much shorter than TAIL_SIZE.
+    const off_t TAIL_SIZE = 64 * 1024;
+    off_t base = st.st_size > TAIL_SIZE ? st.st_size - TAIL_SIZE : 0;
+    std::string tail(static_cast<std::size_t>(st.st_size - base), '\0');
+    for(std::size_t pos = 0; pos < tail.size();)
+    {
+        ssize_t n = pread(mFd, tail.data() + pos, tail.size() - pos, base + static_cast<off_t>(pos));
+        if(n < 0 && errno == EINTR)
+            continue;
+        if(n <= 0)
+            return false;
+        pos += static_cast<std::size_t>(n);
+    }
+
+    // half-written line is removed, and last complete line has current seq.
+    std::string::size_type end = tail.rfind('\n');
+    std::size_t complete = end != std::string::npos ? end + 1 : 0;
+    if(complete != tail.size()
+        && (end != std::string::npos || base == 0))
+    {
+        if(ftruncate(mFd, base + static_cast<off_t>(complete)) != 0)
+            return false;
+        mSize = static_cast<std::uint64_t>(base) + complete;
+    }
+    else
+        mSize = static_cast<std::uint64_t>(st.st_size);
+
+    // malformed lines at end are skipped.
+    mSeq = 0;
+    while(end != std::string::npos)
+    {
+        std::string::size_type begin = end != 0 ? tail.rfind('\n', end - 1) : std::string::npos;
+        Entry entry;
+        if(parse(tail.substr(begin != std::string::npos ? begin + 1 : 0
+            , begin != std::string::npos ? end - begin - 1 : end), entry))
+        {
+            mSeq = entry.seq;
+            break;
+        }
+        end = begin;
+    }
+
+    return true;
+}
+
+Reader::Reader(const std::filesystem::path &file
+    , std::uint64_t offset
+    , std::uint64_t seq)
+    : mFile(file)
+    , mFstr()
+    , mOffset(offset)
+    , mSeq(seq)
+    , mIsReset(false)
+{
+}
+
+bool Reader::next(Entry &entry)
+{
+    if(mIsReset)
+        return false;
+    if(!mFstr.is_open() && !open())
+        return false;
+
+    mFstr.clear();
+    mFstr.seekg(static_cast<std::streamoff>(mOffset));
+
+    // line without '\n' is being written, and it is read next time.
+    // malformed line is skipped.
+    std::string line;
+    while(std::getline(mFstr, line) && !mFstr.eof())
+    {
+        Entry e;
+        if(!parse(line, e))
+        {
+            mOffset += line.size() + 1;
+            continue;
+        }
+
+        if(mSeq != 0 && e.seq != mSeq + 1)
+        {
+            mIsReset = true;
+            return false;
+        }
+
+        mOffset += line.size() + 1;
+        mSeq = e.seq;
+        entry = std::move(e);
+        return true;
+    }
+
+    // file is opened again at next call, so that file created again
+    // after its directory was removed is read instead of removed one.
+    mFstr.close();
+    return false;
+}
+
+bool Reader::open()
+{
+    mFstr.open(mFile);
+    if(!mFstr.is_open())
+        return false;
+
+    // feed only grows, and offset of entry is always after '\n'.
+    char c = '\n';
+    mFstr.seekg(0, std::ios::end);
+    std::uint64_t size = static_cast<std::uint64_t>(mFstr.tellg());
+    if(mOffset > 0 && mOffset <= size)
+    {
+        mFstr.seekg(static_cast<std::streamoff>(mOffset - 1));
+        mFstr.get(c);
+    }
+    if(mOffset > size || c != '\n')
+    {
+        mFstr.close();
+        mIsReset = true;
+        return false;
+    }
+
+    return true;
+}
+
+}
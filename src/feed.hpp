@@ -0,0 +1,103 @@
+#ifndef FEED_HPP
+#define FEED_HPP
+
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <cstdint>
+
+namespace FEED
+{
+
+/* append-only journal of published records.
+// each line is "<seq>\t<repository>\t<hash>\t<location>\n".
+// location is path of record relative to difference_dir.
+// seq starts from 1 and increases by 1 in each file.
+// line is appended after its record is renamed into place,
+// so location in feed always exists.
+// each commit has one line, because GIT::Repository::diff() adds hashes in feed
+// to its seen set before it publishes records.
+*/
+struct Entry
+{
+    std::uint64_t seq = 0;
+    std::string repository;
+    std::string hash;
+    std::string location;
+};
+
+/* appender of feed file.
+// half-written line left by crash is removed by open().
+// append() may be called from multiple threads.
+// open() and append() hold flock on file, and append() reads last seq under it
+// only if size of file differs from size after its last write,
+// so that writers in other processes never duplicate seq.
+*/
+class Writer
+{
+public:
+    Writer();
+    ~Writer();
+
+    Writer(const Writer&) = delete;
+    Writer &operator=(const Writer&) = delete;
+
+    bool open(const std::filesystem::path &file);
+    bool append(const std::string &repository
+        , const std::string &hash
+        , const std::string &location);
+
+private:
+    // remove half-written line and read seq of last line. caller holds flock.
+    bool readTail();
+
+    std::mutex mMutex;
+    int mFd;
+    std::uint64_t mSeq;
+    // size of file when mSeq was read or written.
+    std::uint64_t mSize;
+};
+
+/* cursor-based reader of feed file.
+// offset() is byte position after last entry returned by next(),
+// and seq() is seq of that entry.
+// consumer saves both and passes them to constructor to resume after restart.
+// next() returns false at end of file, and it can be called again later
+// to read entries appended after that.
+// feed is created again from seq 1 if its directory is removed
+// (e.g. repository is dropped after failed pull), and saved cursor is invalid then.
+// next() detects it, because offset is past end of file or not at start of line,
+// or seq of entry does not continue seq(). after that, next() returns false
+// and isReset() returns true, and consumer reads file again from offset 0.
+*/
+class Reader
+{
+public:
+    explicit Reader(const std::filesystem::path &file
+        , std::uint64_t offset = 0
+        , std::uint64_t seq = 0);
+
+    bool next(Entry &entry);
+
+    std::uint64_t offset() const noexcept
+        {return mOffset;}
+    std::uint64_t seq() const noexcept
+        {return mSeq;}
+    bool isReset() const noexcept
+        {return mIsReset;}
+
+private:
+    // open file and check that cursor is in it.
+    bool open();
+
+    std::filesystem::path mFile;
+    std::ifstream mFstr;
+    std::uint64_t mOffset;
+    std::uint64_t mSeq;
+    bool mIsReset;
+};
+
+}
+
+#endif
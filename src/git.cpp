@@ -1,18 +1,332 @@
 #include <utility>
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <system_error>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <random>
 
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/optional.hpp>
 
 #include "system.hpp"
+#include "trace.hpp"
+#include "patch.hpp"
+#include "line.hpp"
+#include "diff.hpp"
 #include "path.hpp"
+#include "pipeline.hpp"
+#include "seen.hpp"
+#include "feed.hpp"
+#include "coprocess.hpp"
+#include "configure.hpp"
 #include "git.hpp"
 
 namespace GIT
 {
 
+namespace
+{
+
+const std::string NULL_SHA(40, '0');
+const std::string SUBMODULE_MODE = "160000";
+
+// one record of git diff-tree --raw -z.
+struct RawEntry
+{
+    std::string srcmode;
+    std::string dstmode;
+    std::string srcsha;
+    std::string dstsha;
+    char status;
+    std::string src;
+    std::string dst;
+};
+
+bool isNullSha(const std::string &sha)
+{
+    return sha.find_first_not_of('0') == std::string::npos;
+}
+
+// ":<srcmode> <dstmode> <srcsha> <dstsha> <status>\0<src>\0[<dst>\0]"
+std::vector<RawEntry> parseRaw(const std::string &str)
+{
+    std::vector<RawEntry> entries;
+    for(std::string::size_type pos = 0; pos < str.size() && str[pos] == ':';)
+    {
+        std::string::size_type np = str.find('\0', pos);
+        if(np == std::string::npos)
+            break;
+
+        RawEntry e;
+        std::string status;
+        std::istringstream header(str.substr(pos + 1, np - pos - 1));
+        header >> e.srcmode >> e.dstmode >> e.srcsha >> e.dstsha >> status;
+        e.status = status.empty() ? ' ' : status.front();
+
+        pos = np + 1;
+        np = str.find('\0', pos);
+        e.src = str.substr(pos, np - pos);
+        pos = np != std::string::npos ? np + 1 : str.size();
+
+        if(e.status == 'R' || e.status == 'C')
+        {
+            np = str.find('\0', pos);
+            e.dst = str.substr(pos, np - pos);
+            pos = np != std::string::npos ? np + 1 : str.size();
+        }
+        else
+            e.dst = e.src;
+
+        entries.push_back(std::move(e));
+    }
+
+    return entries;
+}
+
+// offset and size of each object in output of git cat-file --batch.
+std::unordered_map<std::string, std::pair<std::streamoff, std::size_t>> indexBlobs(std::istream &istr)
+{
+    std::unordered_map<std::string, std::pair<std::streamoff, std::size_t>> offsets;
+
+    std::string header;
+    while(std::getline(istr, header))
+    {
+        std::istringstream sstr(header);
+        std::string sha, type;
+        std::size_t size = 0;
+        if(!(sstr >> sha >> type >> size))
+            continue;
+
+        offsets.emplace(sha, std::make_pair(static_cast<std::streamoff>(istr.tellg()), size));
+        istr.seekg(static_cast<std::streamoff>(size + 1), std::ios::cur);
+    }
+
+    istr.clear();
+    return offsets;
+}
+
+// placeholders of git log --pretty for names in Configure::LOG_FIELD_NAMES.
+const std::unordered_map<std::string, std::string> LOG_FIELD_FORMATS
+{
+    {"author_name", "%an"},
+    {"author_email", "%ae"},
+    {"author_time", "%at"},
+    {"committer_name", "%cn"},
+    {"committer_email", "%ce"},
+    {"committer_time", "%ct"},
+    {"parents", "%P"}
+};
+
+// records and fields of log are separated by RS and US, which never appear in them.
+const char LOG_RECORD_SEPARATOR = '\x1e';
+const char LOG_FIELD_SEPARATOR = '\x1f';
+
+std::vector<std::string> split(const std::string &str
+    , char delim)
+{
+    std::vector<std::string> ret;
+    for(std::string::size_type pos = 0;;)
+    {
+        std::string::size_type np = str.find(delim, pos);
+        ret.push_back(str.substr(pos, np - pos));
+        if(np == std::string::npos)
+            break;
+        pos = np + 1;
+    }
+    return ret;
+}
+
+// line of str in [pos, end), and pos is moved to next line.
+std::string getLine(const std::string &str
+    , std::string::size_type &pos
+    , std::string::size_type end)
+{
+    std::string::size_type np = LINE::find(str, pos);
+    if(np == std::string::npos || np > end)
+        np = end;
+    std::string line(str, pos, np - pos);
+    pos = np < end ? np + 1 : end;
+    return line;
+}
+
+// each line in [pos, end) is "<added>\t<deleted>\t<path>", and binary file has '-' as count.
+void parseNumstat(const std::string &str
+    , std::string::size_type pos
+    , std::string::size_type end
+    , boost::property_tree::ptree &numstat)
+{
+    using namespace boost::property_tree;
+
+    while(pos < end)
+    {
+        std::string line(getLine(str, pos, end));
+        std::string::size_type ap = line.find('\t');
+        std::string::size_type sp = ap != std::string::npos
+            ? line.find('\t', ap + 1)
+                : std::string::npos;
+        if(sp == std::string::npos)
+            continue;
+
+        ptree filenode;
+        filenode.put("path", line.substr(sp + 1));
+        filenode.put("add", line.substr(0, ap));
+        filenode.put("sub", line.substr(ap + 1, sp - ap - 1));
+        numstat.push_back(std::make_pair("", filenode));
+    }
+}
+
+/* record in [pos, end) of log output.
+// "<hash> US <parents> US <subject> [US <field>]... \n [<added> \t <deleted> \t <path> \n]..."
+// numstat lines exist only if log.numstat is true.
+*/
+bool parseLogRecord(const std::string &str
+    , std::string::size_type pos
+    , std::string::size_type end
+    , Commit &commit)
+{
+    using namespace boost::property_tree;
+
+    std::string header(getLine(str, pos, end));
+
+    std::vector<std::string> values(split(header, LOG_FIELD_SEPARATOR));
+    if(values.size() != 3 + Configure::logFields().size())
+        return false;
+
+    commit.hash = values[0];
+    std::vector<std::string> parents(values[1].empty()
+        ? std::vector<std::string>()
+            : split(values[1], ' '));
+    commit.isMerge = parents.size() > 1;
+    commit.subject = values[2];
+
+    for(std::size_t i = 0; i < Configure::logFields().size(); i++)
+    {
+        const std::string &name = Configure::logFields()[i];
+        if(name == "parents")
+        {
+            // write_json() writes empty tree as "", so root commit has no parents.
+            ptree parentnode;
+            for(auto &&p : parents)
+            {
+                ptree ele;
+                ele.put("", p);
+                parentnode.push_back(std::make_pair("", ele));
+            }
+            if(!parentnode.empty())
+                commit.meta.add_child(name, parentnode);
+            commit.meta.put("merge", commit.isMerge);
+        }
+        else
+            commit.meta.put(name, values[3 + i]);
+    }
+
+    parseNumstat(str, pos, end, commit.numstat);
+    return true;
+}
+
+/* line echoed by git diff-tree --stdin after response of each commit.
+// it begins with '-', so that it is never read as object name,
+// and random part keeps it from matching line of patch.
+*/
+const std::string SENTINEL = []
+    {
+        std::random_device rd;
+        std::ostringstream sstr;
+        sstr << "--collector-" << std::hex << rd() << rd() << "--";
+        return sstr.str();
+    }();
+
+long long now()
+{
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+std::size_t countPacks(const std::filesystem::path &objects)
+{
+    std::error_code ec;
+    std::size_t count = 0;
+    for(auto &&e : std::filesystem::directory_iterator(objects / "pack", ec))
+    {
+        if(e.path().extension() == ".pack")
+            count++;
+    }
+    return count;
+}
+
+// loose objects are in objects/<2 hex digits>/.
+std::size_t countLoose(const std::filesystem::path &objects)
+{
+    std::error_code ec;
+    std::size_t count = 0;
+    for(auto &&d : std::filesystem::directory_iterator(objects, ec))
+    {
+        std::string name(d.path().filename().string());
+        if(name.size() != 2
+            || name.find_first_not_of("0123456789abcdef") != std::string::npos)
+            continue;
+
+        std::error_code iec;
+        for(auto &&e : std::filesystem::directory_iterator(d.path(), iec))
+        {
+            (void)e;
+            count++;
+        }
+    }
+    return count;
+}
+
+std::string readBlob(std::istream &istr
+    , const std::unordered_map<std::string, std::pair<std::streamoff, std::size_t>> &offsets
+    , const std::string &sha)
+{
+    auto iter = offsets.find(sha);
+    if(iter == offsets.end())
+        return std::string();
+
+    std::string blob(iter->second.second, '\0');
+    istr.seekg(iter->second.first);
+    istr.read(blob.data(), blob.size());
+    return blob;
+}
+
+}
+
+/* long-lived git processes of one diff() call.
+// patch: same output as show() for each commit id.
+// raw: same output as diff-tree of nativeShow() for each commit id.
+// blob: git cat-file --batch.
+*/
+struct Repository::Pools
+{
+    Pools(const std::filesystem::path &path
+        , std::size_t size)
+        : patch({"git", "-C", path.string(), "diff-tree", "--stdin"
+            , "-M", "-p", "--root", "--cc", "--unified=0", "--minimal", "--no-color"
+            , "--src-prefix=", "--dst-prefix="
+            , "--output-indicator-new=+", "--output-indicator-old=-"
+            , "--ignore-blank-lines", "--ignore-space-change"}, size)
+        , raw({"git", "-C", path.string(), "diff-tree", "--stdin"
+            , "-r", "-M", "-z", "--root", "--raw", "--no-abbrev", "--no-commit-id", "--no-color"}, size)
+        , blob({"git", "-C", path.string(), "cat-file", "--batch"}, size){}
+
+    COPROCESS::Pool patch;
+    COPROCESS::Pool raw;
+    COPROCESS::Pool blob;
+};
+
 bool Repository::clone() const
 {
+    TRACE::Span span("git", "clone", path());
+
     if(PATH::isExist(path() / ".git", std::filesystem::file_type::directory))
         return true;
 
@@ -30,8 +344,99 @@ bool Repository::clone() const
         return outSystemError(cmd);
 }
 
+bool Repository::probe()
+{
+    TRACE::Span span("git", "probe", path());
+
+    mIsChanged = true;
+    mRemoteRefs.clear();
+
+    std::filesystem::path tmp(Configure::tempDir()
+        / (path().filename().string() + ".refs"));
+    if(!PATH::isValid(tmp))
+        return outFileError(tmp);
+
+    std::string cmd(SYSTEM::command("git"
+        , "-C"
+        , path().string()
+        , "ls-remote"
+        , "--heads"
+        , "--tags"
+        , "origin"
+        , ">"
+        , tmp.string()
+        , "2>"
+        , "/dev/null"));
+    if(SYSTEM::system(cmd) != 0)
+    {
+        std::filesystem::remove(tmp);
+        return outSystemError(cmd);
+    }
+
+    mRemoteRefs = PATH::read(tmp);
+    std::filesystem::remove(tmp);
+
+    // configured refs are part of state, so that refs added to repositories json
+    // are collected even if remote is not changed.
+    for(auto &&pattern : mRefs)
+        mRemoteRefs += "glob\t" + pattern + "\n";
+
+    if(PATH::isExist(refsFile()))
+        mIsChanged = PATH::read(refsFile()) != mRemoteRefs;
+
+    return true;
+}
+
+bool Repository::saveRefs() const
+{
+    for(auto &&[file, str] : {std::make_pair(refsFile(), &mRemoteRefs)
+        , std::make_pair(tipsFile(), &mTips)})
+    {
+        if(str->empty())
+            continue;
+
+        std::ofstream fstr(file);
+        if(!fstr.is_open())
+            return outFileError(file);
+
+        fstr << *str;
+        fstr.close();
+        if(!fstr)
+            return outFileError(file);
+    }
+
+    return true;
+}
+
+std::string Repository::host() const
+{
+    // scheme://[user@]host[:port]/path
+    if(std::string::size_type sp = url().find("://"); sp != std::string::npos)
+    {
+        if(url().compare(0, sp, "file") == 0)
+            return std::string();
+
+        std::string authority(url().substr(sp + 3, url().find('/', sp + 3) - sp - 3));
+        if(std::string::size_type ap = authority.rfind('@'); ap != std::string::npos)
+            authority.erase(0, ap + 1);
+        return authority.substr(0, authority.find(':'));
+    }
+
+    // [user@]host:path
+    std::string::size_type cp = url().find(':');
+    if(cp == std::string::npos || url().find('/') < cp)
+        return std::string();
+
+    std::string authority(url().substr(0, cp));
+    if(std::string::size_type ap = authority.rfind('@'); ap != std::string::npos)
+        authority.erase(0, ap + 1);
+    return authority;
+}
+
 bool Repository::pull() const
 {
+    TRACE::Span span("git", "pull", path());
+
     std::string cmd(SYSTEM::command("git"
         , "-C"
         , path().string()
@@ -47,68 +452,461 @@ bool Repository::pull() const
         return outSystemError(cmd);
 }
 
-bool Repository::log(const std::filesystem::path &logpath) const
+bool Repository::maintain() const
 {
+    TRACE::Span span("git", "maintain", path());
+
+    using Clock = std::chrono::steady_clock;
+
+    std::filesystem::path objects(path() / ".git" / "objects");
+    std::size_t packs = countPacks(objects);
+    std::size_t loose = countLoose(objects);
+
+    std::string record(PATH::read(maintenanceFile()));
+    long long last = 0;
+    try
+        {last = std::stoll(record);}
+    catch(const std::exception &e)
+        {last = 0;}
+
+    // after failed repack, thresholds are ignored until maintenance_interval passes,
+    // because packs are still over them and repack would fail every cycle.
+    bool isLastFailed = record.find("failed") != std::string::npos;
+    bool isRepackRequired = (!isLastFailed
+            && (packs > Configure::maintenancePackThreshold()
+                || loose > Configure::maintenanceLooseThreshold()))
+        || now() - last > Configure::maintenanceInterval();
+
+    // commit-graph is written incrementally after every pull,
+    // because new layer has only new commits and it is cheap.
+    // repack and multi-pack-index rewrite packs, so they run only over thresholds.
+    std::vector<std::pair<std::string, std::string>> steps;
+    if(isRepackRequired)
+    {
+        steps.emplace_back("repack", SYSTEM::command("git"
+            , "-C"
+            , path().string()
+            , "repack"
+            , "-d"
+            , "-l"
+            , "--geometric=2"
+            , "--quiet"
+            , ">"
+            , "/dev/null"
+            , "2>&1"));
+        steps.emplace_back("prune-packed", SYSTEM::command("git"
+            , "-C"
+            , path().string()
+            , "prune-packed"
+            , "--quiet"
+            , ">"
+            , "/dev/null"
+            , "2>&1"));
+        steps.emplace_back("multi-pack-index", SYSTEM::command("git"
+            , "-C"
+            , path().string()
+            , "multi-pack-index"
+            , "write"
+            , "--no-progress"
+            , ">"
+            , "/dev/null"
+            , "2>&1"));
+    }
+    steps.emplace_back("commit-graph", SYSTEM::command("git"
+        , "-C"
+        , path().string()
+        , "commit-graph"
+        , "write"
+        , "--reachable"
+        , "--split"
+        , "--no-progress"
+        , ">"
+        , "/dev/null"
+        , "2>&1"));
+
+    // steps are independent, so failed step does not skip following ones
+    // (e.g. git older than 2.32 has no --geometric, but commit-graph is still written).
+    bool isSucceeded = true, isRepackFailed = false;
+    std::vector<std::pair<std::string, long long>> times;
+    for(auto &&[name, cmd] : steps)
+    {
+        auto begin = Clock::now();
+        if(SYSTEM::system(cmd) != 0)
+        {
+            isSucceeded = outSystemError(cmd);
+            isRepackFailed = isRepackFailed || name == "repack";
+            continue;
+        }
+        times.emplace_back(name, std::chrono::duration_cast<std::chrono::milliseconds>(
+            Clock::now() - begin).count());
+    }
+
+    // time is recorded even if repack failed,
+    // so that unsupported repack is retried only after maintenance_interval.
+    if(isRepackRequired)
+    {
+        std::ofstream fstr(maintenanceFile());
+        if(!fstr.is_open())
+            return outFileError(maintenanceFile());
+        fstr << now() << (isRepackFailed ? " failed" : "") << '\n';
+        fstr.close();
+        if(!fstr)
+            return outFileError(maintenanceFile());
+    }
+
+    if(Configure::maintenanceMetrics())
+    {
+        std::clog << "git-maintenance info:\n"
+            "    what: time of maintenance steps.\n"
+            "    path: " << path().string() << "\n"
+            "    before: packs=" << packs << " loose=" << loose << "\n"
+            "    after: packs=" << countPacks(objects) << " loose=" << countLoose(objects) << "\n";
+        for(auto &&[name, ms] : times)
+            std::clog << "    " << name << ": " << ms << "ms\n";
+        std::clog << std::flush;
+    }
+
+    return isSucceeded;
+}
+
+bool Repository::log(const std::filesystem::path &logpath)
+{
+    TRACE::Span span("git", "log", path());
+
     if(!PATH::isValid(logpath))
         return outFileError(logpath);
 
+    // tips are saved by saveRefs() after all commits reachable from them are collected.
+    std::filesystem::path tipspath(logpath.string() + ".tips");
     std::string cmd(SYSTEM::command("git"
         , "-C"
         , path().string()
-        , "log"
-        , "--pretty=format:\"%H\n%s\""
-        , "--output=" + logpath.string()
+        , "rev-parse"
+        , revisions()
         , ">"
-        , "/dev/null"
-        , "2>&1"));
+        , tipspath.string()
+        , "2>"
+        , "/dev/null"));
+    int status = SYSTEM::system(cmd);
+    mTips = status == 0 ? PATH::read(tipspath) : std::string();
+    std::filesystem::remove(tipspath);
+    if(status != 0)
+        return outSystemError(cmd);
+
+    std::string format("%x1e%H%x1f%P%x1f%s");
+    for(auto &&name : Configure::logFields())
+        format += "%x1f" + LOG_FIELD_FORMATS.at(name);
+
+    // history collected at last cycle is excluded, so that only new commits are walked and diffed.
+    std::string collected;
+    std::string tips(PATH::read(tipsFile()));
+    std::string tip;
+    for(std::string::size_type pos = 0; pos < tips.size();)
+    {
+        pos = PATH::getLine(tips, tip, pos);
+        if(tip.size() == NULL_SHA.size()
+            && tip.find_first_not_of("0123456789abcdef") == std::string::npos)
+            collected += (collected.empty() ? "--not " : " ") + tip;
+    }
+
+    auto &&command = [&](const std::string &exclusion)
+        {
+            return SYSTEM::command("git"
+                , "-C"
+                , path().string()
+                , "log"
+                , "--pretty=format:\"" + format + "\""
+                , Configure::logNumstat() ? "--numstat" : ""
+                , "--output=" + logpath.string()
+                , revisions()
+                , exclusion
+                , ">"
+                , "/dev/null"
+                , "2>&1");
+        };
+
+    // saved tip may be lost by force push and gc, so whole history is walked again then.
+    if(!collected.empty()
+        && SYSTEM::system(command(collected)) == 0)
+        return true;
+
+    cmd = command(std::string());
     if(SYSTEM::system(cmd) == 0)
         return true;
     else
         return outSystemError(cmd);
 }
 
+std::string Repository::revisions() const
+{
+    // git log lists commit reachable from several refs only once.
+    std::string ret("HEAD");
+    for(auto &&pattern : mRefs)
+        ret += " \"--glob=" + pattern + "\"";
+    return ret;
+}
+
 bool Repository::diff(const std::filesystem::path &input
-    , const std::filesystem::path &output) const
+    , const std::filesystem::path &output
+    , std::size_t &failed) const
 {
+    TRACE::Span span("git", "diff", path());
+
+    failed = 0;
+
     if(!PATH::isExist(input))
         return outFileError(input);
 
     if(!PATH::isValid(output, std::filesystem::file_type::directory))
         return outFileError(output);
 
-    std::string str = PATH::read(input);
 
-    for(std::string::size_type pos = 0; pos < str.size();)
+    SEEN::Set seen;
+    if(!seen.load(seenFile(output)))
+        seedSeen(output, seen);
+
+    // lines appended after seen file was saved (e.g. by crash in the middle of cycle)
+    // are added to seen, so that commit in feed is never published again.
+    std::uint64_t offset = 0;
+    try
+        {offset = std::stoull(PATH::read(seenOffsetFile(output)));}
+    catch(const std::exception &e)
+        {offset = 0;}
+    FEED::Reader reader(feedFile(output), offset);
+    FEED::Entry entry;
+    while(reader.next(entry))
+        seen.insert(entry.hash);
+    if(reader.isReset())
     {
-        std::string hash, subject;
-        pos = PATH::getLine(str, hash, pos);
-        pos = PATH::getLine(str, subject, pos);
+        reader = FEED::Reader(feedFile(output));
+        while(reader.next(entry))
+            seen.insert(entry.hash);
+    }
+
+    // commit that is not in feed is never published, so no record is written without feed.
+    // published records and feed are kept, and commits are retried at next cycle.
+    FEED::Writer feed;
+    bool isFeedOpen = feed.open(feedFile(output));
+    if(!isFeedOpen)
+        outFileError(feedFile(output));
+
+    // one process of each kind per show thread, so that show threads never wait for each other.
+    std::unique_ptr<Pools> pools(Configure::coprocess()
+        ? std::make_unique<Pools>(path(), Configure::showThreads())
+            : nullptr);
 
-        std::filesystem::path json(output / (hash + ".json"));
-        if(!PATH::isExist(json))
+    // log -> show -> parse -> serialize -> write.
+    // each stage runs on its own threads, and bounded queues between stages
+    // keep number of commits in memory constant.
+    using Queue = PIPELINE::Queue<std::unique_ptr<Commit>>;
+    std::size_t capacity = Configure::queueCapacity();
+    Queue showq(capacity), parseq(capacity), serializeq(capacity), writeq(capacity);
+    // queues bound number of commits, and budget bounds bytes of their records.
+    PIPELINE::Budget budget(Configure::pipelineMemoryBudget());
+
+    // commits that failed in any stage are counted, so that caller can retry them.
+    std::atomic<std::size_t> failures(0);
+
+    std::vector<std::thread> stages;
+    stages.push_back(PIPELINE::stage(Configure::showThreads(), showq, parseq
+        , [this, &pools, &failures](std::unique_ptr<Commit> &c)
+        {
+            // git show cannot write combined diff of merge with --output,
+            // so merge is recorded with metadata only.
+            if(c->isMerge)
+                return true;
+
+            c->showpath = Configure::tempDir() / c->hash;
+            if(Configure::diffEngine() == Configure::DIFF_ENGINE_NATIVE
+                ? nativeShow(*c, pools.get())
+                    : show(c->showpath, c->hash, pools.get()))
+                return true;
+            outDiffWarning(c->hash);
+            failures++;
+            return false;
+        }));
+    stages.push_back(PIPELINE::stage(Configure::parseThreads(), parseq, serializeq
+        , [this, &budget, &failures](std::unique_ptr<Commit> &c)
         {
-            if(!outputDiff(json, hash, subject))
+            if(c->showpath.empty())
+                return true;
+
+            // records of commit never exceed commit budget, so it is reserved before parse,
+            // and the rest of it is released after records are made.
+            std::size_t reserved = Configure::commitMemoryBudget();
+            budget.acquire(reserved);
+
+            bool isSuccessful = c->isNative
+                ? nativeParse(*c)
+                    : parseShow(*c);
+            std::filesystem::remove(c->showpath);
+            if(!c->blobpath.empty())
+                std::filesystem::remove(c->blobpath);
+            if(isSuccessful)
+            {
+                c->memory = std::min(c->memory, reserved);
+                budget.release(reserved - c->memory);
+                return true;
+            }
+            budget.release(reserved);
+            outDiffWarning(c->hash);
+            failures++;
+            return false;
+        }));
+    stages.push_back(PIPELINE::stage(Configure::serializeThreads(), serializeq, writeq
+        , [this, &budget, &failures](std::unique_ptr<Commit> &c)
+        {
+            // records are freed by serialize(), and JSON text is never held in memory.
+            bool isSuccessful = serialize(*c);
+            budget.release(c->memory);
+            if(isSuccessful)
+                return true;
+            outDiffWarning(c->hash);
+            failures++;
+            return false;
+        }));
+    stages.push_back(PIPELINE::stage(Configure::writeThreads(), writeq
+        , [this, &seen, &feed, &failures](std::unique_ptr<Commit> &c)
+        {
+            if(!outputDiff(*c))
+            {
+                outDiffWarning(c->hash);
+                failures++;
+                return;
+            }
+
+            // commit is regarded as seen only after it is in feed,
+            // so that commit whose line failed to be appended is written again at next cycle.
+            // location is relative to difference_dir, so that consumers in other directories can use it.
+            if(!feed.append(path().filename().string()
+                , c->hash
+                , (c->output.parent_path().filename() / c->output.filename()).string()))
             {
-                std::cerr << "git-diff warning:\n"
-                    "    what: failed to output difference file.\n"
-                    "    path: " << path().string() << "\n"
-                    "    url: " << url() << "\n"
-                    "    hash: " << hash << "\n"
-                    "    approach: ignore this hash.\n"
-                    << std::flush;
+                outFileError(feedFile(c->output.parent_path()));
+                outDiffWarning(c->hash);
+                failures++;
+                return;
             }
+            seen.insert(c->hash);
+        }));
+
+    // log is read record by record, so that whole log is never in memory.
+    std::ifstream logstr(input, std::ios::binary);
+    std::string record;
+    while(std::getline(logstr, record, LOG_RECORD_SEPARATOR))
+    {
+        if(record.empty())
+            continue;
+
+        auto c = std::make_unique<Commit>();
+        if(!parseLogRecord(record, 0, record.size(), *c))
+        {
+            outDiffWarning(c->hash);
+            failures++;
+            continue;
+        }
+
+        if(seen.contains(c->hash))
+            continue;
+        if(!isFeedOpen)
+        {
+            failures++;
+            continue;
+        }
+
+        c->output = output / (c->hash + ".json");
+        showq.push(std::move(c));
+    }
+    showq.close();
+
+    for(auto &&t : stages)
+        t.join();
+    failed = failures;
+
+    while(reader.next(entry))
+        seen.insert(entry.hash);
+
+    // previous owner of shard may still save them, so both are replaced at once.
+    if(!seen.save(seenFile(output), tmpFile(seenFile(output))))
+        outFileError(seenFile(output));
+    else
+    {
+        std::filesystem::path tmp(tmpFile(seenOffsetFile(output)));
+        std::ofstream fstr(tmp);
+        if(fstr.is_open())
+            fstr << reader.offset() << '\n';
+        fstr.close();
+        std::error_code ec;
+        if(fstr)
+            std::filesystem::rename(tmp, seenOffsetFile(output), ec);
+        if(!fstr || ec)
+        {
+            std::filesystem::remove(tmp, ec);
+            outFileError(seenOffsetFile(output));
         }
     }
 
+    if(Configure::pipelineMetrics())
+    {
+        std::clog << "git-diff info:\n"
+            "    what: pipeline queue occupancy and memory in flight.\n"
+            "    path: " << path().string() << "\n";
+        for(auto &&[name, q] : {std::make_pair("show", &showq)
+            , std::make_pair("parse", &parseq)
+            , std::make_pair("serialize", &serializeq)
+            , std::make_pair("write", &writeq)})
+        {
+            std::clog << "    " << name << ": "
+                "pushed=" << q->pushed()
+                << " peak=" << q->peak() << "/" << q->capacity()
+                << " average=" << q->average()
+                << " blocked=" << q->blocked() << "\n";
+        }
+        std::clog << "    memory: "
+            "peak=" << budget.peak() << "/" << budget.capacity()
+            << " blocked=" << budget.blocked() << "\n";
+        std::clog << std::flush;
+    }
+
     return true;
 }
 
+void Repository::seedSeen(const std::filesystem::path &output
+    , SEEN::Set &seen) const
+{
+    // records written before seen file existed.
+    std::error_code ec;
+    for(auto &&e : std::filesystem::directory_iterator(output, ec))
+    {
+        if(e.path().extension() == ".json")
+            seen.insert(e.path().stem().string());
+    }
+}
+
 bool Repository::show(const std::filesystem::path &output
-    , const std::string &hash) const
+    , const std::string &hash
+    , Pools *pools) const
 {
+    TRACE::Span span("git", "show", hash);
+
     if(!PATH::isValid(output))
         return outFileError(output);
 
+    if(pools)
+    {
+        if(auto lease = pools->patch.acquire(); lease)
+        {
+            TRACE::Span span("coprocess", "patch", hash);
+            std::ofstream fstr(output, std::ios::binary);
+            if(fstr.is_open()
+                && lease->write(hash + "\n" + SENTINEL + "\n")
+                && lease->readUntil(SENTINEL, fstr))
+                return true;
+            lease.fail();
+        }
+        outCoprocessWarning(hash);
+    }
+
     std::string cmd(SYSTEM::command("git"
         , "-C"
         , path().string()
@@ -148,8 +946,13 @@ bool Repository::setUrl()
 {
     if(!PATH::isExist(path(), std::filesystem::file_type::directory))
         return false;
+
+    if(readConfigUrl())
+        return true;
     
-    std::filesystem::path tmp(std::filesystem::temp_directory_path() / path().filename());
+    std::filesystem::path tmp(Configure::tempDir() / path().filename());
+    if(!PATH::isValid(tmp))
+        return outFileError(tmp);
 
     std::string cmd = SYSTEM::command("git"
         , "-C"
@@ -170,88 +973,568 @@ bool Repository::setUrl()
         return outSystemError(cmd);
 }
 
-bool Repository::parseShow(const std::filesystem::path &showpath
-    , boost::property_tree::ptree &tree) const
+bool Repository::nativeShow(Commit &commit
+    , Pools *pools) const
 {
-    std::string str(PATH::read(showpath));
+    TRACE::Span span("git", "nativeShow", commit.hash);
 
-    std::string line;
-    for(std::string::size_type fp = str.find("\n---"); fp != std::string::npos; fp = str.find("\n---", fp))
+    if(!PATH::isValid(commit.showpath))
+        return outFileError(commit.showpath);
+
+    if(pools)
+    {
+        if(nativeShowByPools(commit, *pools))
+            return true;
+        outCoprocessWarning(commit.hash);
+    }
+
+    std::string cmd(SYSTEM::command("git"
+        , "-C"
+        , path().string()
+        , "diff-tree"
+        , "-r"
+        , "-M"
+        , "-z"
+        , "--root"
+        , "--raw"
+        , "--no-abbrev"
+        , "--no-commit-id"
+        , "--no-color"
+        , commit.hash
+        , ">"
+        , commit.showpath.string()
+        , "2>"
+        , "/dev/null"));
+    if(SYSTEM::system(cmd) != 0)
+        return outSystemError(cmd);
+
+    // commit without change has no blob to read, and nativeParse() makes no record.
+    std::vector<RawEntry> entries(parseRaw(PATH::read(commit.showpath)));
+    if(entries.empty())
+    {
+        commit.isNative = true;
+        return true;
+    }
+
+    std::filesystem::path listpath(commit.showpath.string() + ".list");
+    commit.blobpath = commit.showpath.string() + ".blob";
+    {
+        std::ofstream fstr(listpath);
+        if(!fstr.is_open())
+            return outFileError(listpath);
+        for(auto &&e : entries)
+        {
+            if(!isNullSha(e.srcsha) && e.srcmode != SUBMODULE_MODE)
+                fstr << e.srcsha << '\n';
+            if(!isNullSha(e.dstsha) && e.dstmode != SUBMODULE_MODE)
+                fstr << e.dstsha << '\n';
+        }
+    }
+
+    cmd = SYSTEM::command("git"
+        , "-C"
+        , path().string()
+        , "cat-file"
+        , "--batch"
+        , "<"
+        , listpath.string()
+        , ">"
+        , commit.blobpath.string()
+        , "2>"
+        , "/dev/null");
+    int status = SYSTEM::system(cmd);
+    std::filesystem::remove(listpath);
+    if(status != 0)
+        return outSystemError(cmd);
+
+    commit.isNative = true;
+    return true;
+}
+
+bool Repository::nativeShowByPools(Commit &commit
+    , Pools &pools) const
+{
+    std::ostringstream raw;
     {
-        fp++;
-        boost::property_tree::ptree filenode;
+        auto lease = pools.raw.acquire();
+        if(!lease)
+            return false;
+        TRACE::Span span("coprocess", "raw", commit.hash);
+        if(!lease->write(commit.hash + "\n" + SENTINEL + "\n")
+            || !lease->readUntil(SENTINEL, raw))
+        {
+            lease.fail();
+            return false;
+        }
+    }
 
-        fp = PATH::getLine(str, line, fp);
-        filenode.put("src", line.substr(4));
+    {
+        std::ofstream fstr(commit.showpath, std::ios::binary);
+        if(!fstr.is_open())
+            return outFileError(commit.showpath);
+        fstr << raw.str();
+    }
 
-        fp = PATH::getLine(str, line, fp);
-        filenode.put("dst", line.substr(4));
+    // commit without change has no blob to read, and nativeParse() makes no record.
+    std::vector<RawEntry> entries(parseRaw(raw.str()));
+    if(entries.empty())
+    {
+        commit.isNative = true;
+        return true;
+    }
+
+    // blobs are written in format of git cat-file --batch, which nativeParse() reads.
+    commit.blobpath = commit.showpath.string() + ".blob";
+    std::ofstream fstr(commit.blobpath, std::ios::binary);
+    if(!fstr.is_open())
+        return outFileError(commit.blobpath);
+
+    auto lease = pools.blob.acquire();
+    if(!lease)
+        return false;
 
-        std::string::size_type nextfp = str.find("\n---", fp - 1);
-        boost::property_tree::ptree hunknode;
-        for(std::string::size_type hp = str.find("\n@@", fp - 1); hp != std::string::npos || hp > nextfp; hp = str.find("\n@@", hp - 1))
+    // blobs are requested in same order as nativeParse() reads them.
+    // like nativeParse(), blobs of each file are checked against budget alone.
+    // content of file that exceeds budget is discarded, and no more blobs are requested,
+    // so that nativeParse() stops at that file and applies oversize policy.
+    bool isOversize = false;
+    std::string header;
+    for(auto &&e : entries)
+    {
+        // type change is two files, deletion and addition, in nativeParse().
+        std::size_t used = 0;
+        for(auto &&[sha, mode] : {std::make_pair(&e.srcsha, &e.srcmode)
+            , std::make_pair(&e.dstsha, &e.dstmode)})
         {
-            hp++;
-            boost::property_tree::ptree hunktree;
-
-            hp = PATH::getLine(str, line, hp);
-            hunktree.put("info", line.substr(0, line.find("@@", 2) + 2));
-            
-            boost::property_tree::ptree subnode, addnode;
-            while(hp < str.size() && str[hp] == '+' || str[hp] == '-')
+            if(isOversize)
+                break;
+            if(e.status == 'T')
+                used = 0;
+            if(isNullSha(*sha) || *mode == SUBMODULE_MODE)
+                continue;
+
+            TRACE::Span span("coprocess", "blob", *sha);
+            if(!lease->write(*sha + "\n") || !lease->readLine(header))
             {
-                hp = PATH::getLine(str, line, hp);
-                boost::property_tree::ptree ele;
-                ele.put("", line.substr(1));
-                (line.front() == '+' ? addnode : subnode).push_back(std::make_pair("", ele));
+                lease.fail();
+                return false;
+            }
+
+            // "<sha> <type> <size>", or "<sha> missing".
+            fstr << header << '\n';
+            std::istringstream sstr(header);
+            std::string rsha, type;
+            std::size_t size = 0;
+            if(!(sstr >> rsha >> type >> size))
+                continue;
 
-                fp = hp - 1;
+            used += size;
+            isOversize = used > Configure::commitMemoryBudget();
+            if(isOversize
+                ? !lease->skip(size + 1)
+                    : !lease->read(size + 1, fstr))
+            {
+                lease.fail();
+                return false;
             }
-            
+        }
+
+        if(isOversize)
+            break;
+    }
+
+    fstr.close();
+    if(!fstr)
+        return outFileError(commit.blobpath);
+
+    commit.isNative = true;
+    return true;
+}
+
+bool Repository::nativeParse(Commit &commit) const
+{
+    TRACE::Span span("git", "nativeParse", commit.hash);
+
+    using namespace boost::property_tree;
+
+    std::vector<RawEntry> entries(parseRaw(PATH::read(commit.showpath)));
+    if(entries.empty())
+        return true;
+
+    std::ifstream blobs(commit.blobpath, std::ios::binary);
+    if(!blobs.is_open())
+        return outFileError(commit.blobpath);
+    auto offsets = indexBlobs(blobs);
+
+    auto &&content = [&](const std::string &sha, const std::string &mode)
+        {
+            if(isNullSha(sha))
+                return std::string();
+            if(mode == SUBMODULE_MODE)
+                return "Subproject commit " + sha + "\n";
+            return readBlob(blobs, offsets, sha);
+        };
+    auto &&size = [&](const std::string &sha, const std::string &mode)
+        {
+            if(isNullSha(sha))
+                return std::size_t(0);
+            if(mode == SUBMODULE_MODE)
+                return sha.size() + 19;
+            auto iter = offsets.find(sha);
+            return iter != offsets.end()
+                ? iter->second.second
+                    : std::size_t(0);
+        };
+
+    // type change is shown as deletion and addition like git show.
+    std::vector<RawEntry> pairs;
+    for(auto &&e : entries)
+    {
+        if(e.status == 'T')
+        {
+            pairs.push_back(RawEntry{e.srcmode, std::string(), e.srcsha, NULL_SHA, 'D', e.src, e.dst});
+            pairs.push_back(RawEntry{std::string(), e.dstmode, NULL_SHA, e.dstsha, 'A', e.src, e.dst});
+        }
+        else
+            pairs.push_back(e);
+    }
+
+    // like PATCH::Parser, only records are charged cumulatively,
+    // and file in progress is dropped when they exceed budget.
+    std::size_t used = 0;
+    bool isOversize = false;
+    auto &&charge = [&](std::size_t n)
+        {
+            used += n;
+            isOversize = used > Configure::commitMemoryBudget();
+            return !isOversize;
+        };
+
+    for(auto &&e : pairs)
+    {
+        // blobs of each file are freed before next file, so they are checked alone.
+        // pair over budget is never loaded.
+        if(size(e.srcsha, e.srcmode) + size(e.dstsha, e.dstmode) > Configure::commitMemoryBudget())
+        {
+            isOversize = true;
+            break;
+        }
+
+        std::string oldblob(content(e.srcsha, e.srcmode));
+        std::string newblob(content(e.dstsha, e.dstmode));
+
+        // git show prints "Binary files ... differ" without file header.
+        if(DIFF::isBinary(oldblob) || DIFF::isBinary(newblob))
+            continue;
+
+        // common tail does not appear in output of --unified=0.
+        std::size_t tail = DIFF::commonTail(oldblob, newblob);
+        std::vector<LINE::Line> oldlines(LINE::index(oldblob.data(), oldblob.size() - tail))
+            , newlines(LINE::index(newblob.data(), newblob.size() - tail));
+        DIFF::Classifier classifier;
+        std::vector<std::uint32_t> oldids, newids;
+        std::vector<int> oldindents, newindents;
+        for(auto &&l : oldlines)
+        {
+            oldids.push_back(classifier.id(oldblob.data() + l.pos, l.size));
+            oldindents.push_back(DIFF::indent(oldblob.data() + l.pos, l.size));
+        }
+        for(auto &&l : newlines)
+        {
+            newids.push_back(classifier.id(newblob.data() + l.pos, l.size));
+            newindents.push_back(DIFF::indent(newblob.data() + l.pos, l.size));
+        }
+
+        auto &&range = [](std::size_t first, std::size_t count)
+            {
+                std::string str(std::to_string(count == 0 ? first : first + 1));
+                return count == 1
+                    ? str
+                        : str + "," + std::to_string(count);
+            };
+        auto &&isBlank = [](const std::string &blob
+            , const std::vector<LINE::Line> &lines
+            , std::size_t first
+            , std::size_t count)
+            {
+                for(std::size_t i = first; i < first + count; i++)
+                {
+                    if(!DIFF::isBlank(blob.data() + lines[i].pos, lines[i].size))
+                        return false;
+                }
+                return true;
+            };
+
+        // sizes are same as lines of git show that PATCH::Parser charges.
+        std::string src(isNullSha(e.srcsha) ? std::string("/dev/null") : e.src);
+        std::string dst(isNullSha(e.dstsha) ? std::string("/dev/null") : e.dst);
+        if(!charge(src.size() + dst.size() + 4 + PATCH::Parser::NODE_SIZE * 3))
+            break;
+
+        ptree hunknode;
+        for(auto &&c : DIFF::diff(oldids, oldindents, newids, newindents))
+        {
+            // --ignore-blank-lines with --unified=0 drops change that has only blank lines.
+            if(isBlank(oldblob, oldlines, c.first1, c.count1)
+                && isBlank(newblob, newlines, c.first2, c.count2))
+                continue;
+
+            std::string info("@@ -" + range(c.first1, c.count1)
+                + " +" + range(c.first2, c.count2) + " @@");
+            if(!charge(info.size() + PATCH::Parser::NODE_SIZE))
+                break;
+
+            ptree hunktree;
+            hunktree.put("info", info);
+
+            ptree subnode, addnode;
+            for(std::size_t i = c.first1; i < c.first1 + c.count1 && !isOversize; i++)
+            {
+                if(!charge(oldlines[i].size + 1 + PATCH::Parser::NODE_SIZE))
+                    break;
+                ptree ele;
+                ele.put("", oldblob.substr(oldlines[i].pos, oldlines[i].size));
+                subnode.push_back(std::make_pair("", ele));
+            }
+            for(std::size_t i = c.first2; i < c.first2 + c.count2 && !isOversize; i++)
+            {
+                if(!charge(newlines[i].size + 1 + PATCH::Parser::NODE_SIZE))
+                    break;
+                ptree ele;
+                ele.put("", newblob.substr(newlines[i].pos, newlines[i].size));
+                addnode.push_back(std::make_pair("", ele));
+            }
+            if(isOversize)
+                break;
+
             if(!subnode.empty())
                 hunktree.add_child("sub", subnode);
             if(!addnode.empty())
                 hunktree.add_child("add", addnode);
-
             hunknode.push_back(std::make_pair("", hunktree));
         }
 
-        if(!hunknode.empty())
-            filenode.add_child("hunk", hunknode);
+        if(isOversize)
+            break;
+        if(hunknode.empty())
+            continue;
 
-        tree.push_back(std::make_pair("", filenode));
+        ptree filenode;
+        filenode.put("src", src);
+        filenode.put("dst", dst);
+        filenode.add_child("hunk", hunknode);
+        commit.tree.push_back(std::make_pair("", filenode));
     }
 
+    commit.memory = used;
+    if(!isOversize)
+        return true;
+
+    commit.oversize = Configure::oversizePolicy();
+    if(commit.oversize == Configure::OVERSIZE_NUMSTAT)
+    {
+        commit.tree.clear();
+        return numstat(commit);
+    }
+    else if(commit.oversize == Configure::OVERSIZE_SKIP)
+        commit.tree.clear();
+
     return true;
 }
 
-bool Repository::outputDiff(const std::filesystem::path &output
-    , const std::string &hash
-    , const std::string &subject) const
+bool Repository::readConfigUrl()
 {
-    using namespace boost::property_tree;
-    using namespace boost;
-    
-    if(!PATH::isValid(output))
-        return outFileError(output);
+    std::string str(PATH::read(path() / ".git" / "config"));
 
-    if(!show(std::filesystem::temp_directory_path() / hash, hash))
-        return false;
-    
-    boost::property_tree::ptree difftree;
-    if(!parseShow(std::filesystem::temp_directory_path() / hash, difftree))
+    auto &&trim = [](const std::string &s)
+        {
+            std::string::size_type b = s.find_first_not_of(" \t\r");
+            std::string::size_type e = s.find_last_not_of(" \t\r");
+            return b != std::string::npos
+                ? s.substr(b, e - b + 1)
+                    : std::string();
+        };
+
+    // only plain 'url = <value>' in '[remote "origin"]' is accepted.
+    // otherwise (include, escape, ...) git config is used.
+    // last value is used like git config --get.
+    bool isOrigin = false;
+    std::string url;
+    std::string line;
+    for(std::string::size_type pos = 0; pos < str.size();)
+    {
+        pos = PATH::getLine(str, line, pos);
+        line = trim(line);
+        if(line.empty() || line.front() == '#' || line.front() == ';')
+            continue;
+
+        if(line.front() == '[')
+        {
+            if(line.compare(0, 8, "[include") == 0)
+                return false;
+            isOrigin = line == "[remote \"origin\"]";
+            continue;
+        }
+
+        std::string::size_type ep = line.find('=');
+        if(!isOrigin
+            || ep == std::string::npos
+            || trim(line.substr(0, ep)) != "url")
+            continue;
+
+        std::string value(trim(line.substr(ep + 1)));
+        if(value.empty()
+            || value.find_first_of("\"\\;#") != std::string::npos)
+            return false;
+
+        url = value;
+    }
+
+    if(url.empty())
         return false;
 
-    ptree tree;
-    tree.put("hash", hash);
-    tree.put("subject", subject);
-    if(!difftree.empty())
-        tree.add_child("difference", difftree);
+    mUrl = url;
+    return true;
+}
+
+bool Repository::parseShow(Commit &commit) const
+{
+    TRACE::Span span("git", "parseShow", commit.hash);
+
+    PATCH::Parser parser(Configure::commitMemoryBudget());
+    if(!parser.parse(commit.showpath))
+        return outFileError(commit.showpath);
+
+    commit.memory = parser.used();
+    if(!parser.isOversize())
+    {
+        commit.tree = std::move(parser.tree());
+        return true;
+    }
+
+    commit.oversize = Configure::oversizePolicy();
+    if(commit.oversize == Configure::OVERSIZE_TRUNCATE)
+        commit.tree = std::move(parser.tree());
+    else if(commit.oversize == Configure::OVERSIZE_NUMSTAT)
+        return numstat(commit);
 
-    write_json(output.string(), tree);
     return true;
 }
 
+bool Repository::numstat(Commit &commit) const
+{
+    TRACE::Span span("git", "numstat", commit.hash);
+
+    // numstat was already read by log().
+    if(Configure::logNumstat())
+        return true;
+
+    if(!PATH::isValid(commit.showpath))
+        return outFileError(commit.showpath);
+
+    std::string cmd(SYSTEM::command("git"
+        , "-C"
+        , path().string()
+        , "show"
+        , "--numstat"
+        , "--format=\"\""
+        , "--output=" + commit.showpath.string()
+        , commit.hash
+        , ">"
+        , "/dev/null"
+        , "2>&1"));
+    if(SYSTEM::system(cmd) != 0)
+        return outSystemError(cmd);
+
+    std::string str(PATH::read(commit.showpath));
+    parseNumstat(str, 0, str.size(), commit.numstat);
+    std::filesystem::remove(commit.showpath);
+    return true;
+}
+
+bool Repository::serialize(Commit &commit) const
+{
+    TRACE::Span span("git", "serialize", commit.hash);
+
+    using namespace boost::property_tree;
+
+    ptree tree;
+    tree.put("hash", commit.hash);
+    tree.put("subject", commit.subject);
+    for(auto &&child : commit.meta)
+        tree.push_back(child);
+    if(!commit.oversize.empty())
+        tree.put("oversize", commit.oversize);
+    // records are moved, so that they are not held twice.
+    if(!commit.tree.empty())
+        tree.add_child("difference", ptree()).swap(commit.tree);
+    if(!commit.numstat.empty())
+        tree.add_child("numstat", ptree()).swap(commit.numstat);
+    commit.meta.clear();
+
+    // JSON text is written to file directly, so that it is never held in memory.
+    // file is renamed by outputDiff(), so that readers and other instances
+    // sharing difference directory never see half of it.
+    commit.jsonpath = tmpFile(commit.output);
+    if(!PATH::isValid(commit.jsonpath))
+        return outFileError(commit.jsonpath);
+
+    std::ofstream fstr(commit.jsonpath);
+    if(!fstr.is_open())
+        return outFileError(commit.jsonpath);
+
+    try
+        {write_json(fstr, tree);}
+    catch(const std::exception &e)
+        {fstr.setstate(std::ios::failbit);}
+
+    fstr.close();
+    if(fstr)
+        return true;
+
+    std::filesystem::remove(commit.jsonpath);
+    return outFileError(commit.jsonpath);
+}
+
+bool Repository::outputDiff(const Commit &commit) const
+{
+    TRACE::Span span("git", "outputDiff", commit.hash);
+
+    std::error_code ec;
+    std::filesystem::rename(commit.jsonpath, commit.output, ec);
+    if(!ec)
+        return true;
+
+    std::filesystem::remove(commit.jsonpath, ec);
+    return outFileError(commit.output);
+}
+
+void Repository::outDiffWarning(const std::string &hash) const
+{
+    std::cerr << "git-diff warning:\n"
+        "    what: failed to output difference file.\n"
+        "    path: " << path().string() << "\n"
+        "    url: " << url() << "\n"
+        "    hash: " << hash << "\n"
+        "    approach: ignore this hash.\n"
+        << std::flush;
+}
+
+void Repository::outCoprocessWarning(const std::string &hash) const
+{
+    std::cerr << "git-coprocess warning:\n"
+        "    what: failed to read commit from long-lived git process.\n"
+        "    path: " << path().string() << "\n"
+        "    hash: " << hash << "\n"
+        "    approach: restart process, and spawn git for this hash.\n"
+        << std::flush;
+}
+
+std::filesystem::path Repository::tmpFile(const std::filesystem::path &file)
+{
+    return file.string() + "." + std::to_string(Configure::shardInstance()) + ".tmp";
+}
+
 bool Repository::outSystemError(const std::string &cmd) const
 {
     std::cerr << "system error:\n"
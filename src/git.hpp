@@ -3,50 +3,146 @@
 
 #include <filesystem>
 #include <string>
+#include <vector>
 #include <utility>
+#include <cstddef>
 
 #include <boost/property_tree/ptree.hpp>
 
+namespace SEEN{class Set;}
+
 namespace GIT
 {
 
+// element passed between stages of Repository::diff().
+struct Commit
+{
+    std::string hash;
+    std::string subject;
+    // fields of log.fields in order.
+    boost::property_tree::ptree meta;
+    bool isMerge = false;
+    std::filesystem::path output;
+    std::filesystem::path showpath;
+    // if isNative is true, showpath is output of git diff-tree --raw,
+    // and blobpath is output of git cat-file --batch, or empty if commit has no change.
+    bool isNative = false;
+    std::filesystem::path blobpath;
+    boost::property_tree::ptree tree;
+    // empty or policy applied to commit that exceeds memory budget.
+    std::string oversize;
+    boost::property_tree::ptree numstat;
+    // JSON written by serialize(), and renamed to output by outputDiff().
+    std::filesystem::path jsonpath;
+    // estimated size of records, held in budget of diff() until they are serialized.
+    std::size_t memory = 0;
+};
+
 class Repository
 {
 public:
     Repository(const std::filesystem::path &p
         , const std::string &u)
         : mPath(p)
-        , mUrl(u){}
+        , mUrl(u)
+        , mIsChanged(true)
+        , mRemoteRefs()
+        , mTips()
+        , mRefs(){}
 
     bool clone() const;
+    /* compare refs of remote and patterns of setRefs() with ones seen at last saveRefs().
+    // if they are same, isChanged() returns false.
+    // if remote is not reachable, repository is regarded as changed.
+    */
+    bool probe();
+    // save remote refs of probe() and tips of log().
+    // caller calls it only after all commits of log() are collected.
+    bool saveRefs() const;
     bool pull() const;
-    bool log(const std::filesystem::path &logpath) const;
+    /* write commit-graph, and repack if pack count, loose object count
+    // or time since last repack exceeds thresholds of Configure.
+    */
+    bool maintain() const;
+    // commits reachable from tips saved by last saveRefs() are not listed.
+    bool log(const std::filesystem::path &logpath);
+    // failed is number of commits whose record was not written.
     bool diff(const std::filesystem::path &input
-        , const std::filesystem::path &output) const;
+        , const std::filesystem::path &output
+        , std::size_t &failed) const;
 
     void remove(const std::filesystem::path &diffdir) const;
+    // read url from .git/config, and use git config if it is failed.
     bool setUrl();
 
     const std::filesystem::path &path() const noexcept
         {return mPath;}
     const std::string &url() const noexcept
         {return mUrl;}
+    bool isChanged() const noexcept
+        {return mIsChanged;}
+    // glob patterns of refs (git log --glob) collected in addition to HEAD.
+    // e.g. "refs/remotes/origin/release/*".
+    void setRefs(const std::vector<std::string> &refs)
+        {mRefs = refs;}
+    // host part of url. empty if url is local path or file://.
+    std::string host() const;
 
 private:
-    bool show(const std::filesystem::path &output
-        , const std::string &hash) const;
-    bool parseShow(const std::filesystem::path &showpath
-        , boost::property_tree::ptree&) const;
+    std::string revisions() const;
+    void seedSeen(const std::filesystem::path &output
+        , SEEN::Set&) const;
+    struct Pools;
 
-    bool outputDiff(const std::filesystem::path &output
+    // if pools is not null, long-lived git processes are used instead of spawning git.
+    bool show(const std::filesystem::path &output
         , const std::string &hash
-        , const std::string &subject) const;
+        , Pools *pools) const;
+    bool nativeShow(Commit&
+        , Pools *pools) const;
+    bool nativeShowByPools(Commit&
+        , Pools&) const;
+    bool nativeParse(Commit&) const;
+    bool readConfigUrl();
+    bool parseShow(Commit&) const;
+    bool numstat(Commit&) const;
+
+    // write JSON of commit to jsonpath and free records.
+    bool serialize(Commit&) const;
+    bool outputDiff(const Commit&) const;
+    void outDiffWarning(const std::string &hash) const;
+    void outCoprocessWarning(const std::string &hash) const;
 
     bool outSystemError(const std::string &cmd) const;
     bool outFileError(const std::filesystem::path&) const;
 
+    std::filesystem::path refsFile() const
+        {return mPath / ".git" / "collector-refs";}
+    // hashes of HEAD and refs whose history is collected.
+    std::filesystem::path tipsFile() const
+        {return mPath / ".git" / "collector-tips";}
+    // hashes of commits whose record is in output directory.
+    static std::filesystem::path seenFile(const std::filesystem::path &output)
+        {return output / ".seen";}
+    // byte offset of feed up to which hashes are in seen file.
+    static std::filesystem::path seenOffsetFile(const std::filesystem::path &output)
+        {return output / ".seen.offset";}
+    // temporary file of this instance, which is renamed to file.
+    // instances sharing difference directory never write same temporary file.
+    static std::filesystem::path tmpFile(const std::filesystem::path &file);
+    // journal of records published by diff(). see FEED::Writer.
+    static std::filesystem::path feedFile(const std::filesystem::path &output)
+        {return output / ".feed";}
+    // time (seconds since epoch) of last repack, followed by "failed" if it failed.
+    std::filesystem::path maintenanceFile() const
+        {return mPath / ".git" / "collector-maintenance";}
+
     std::filesystem::path mPath;
     std::string mUrl;
+    bool mIsChanged;
+    std::string mRemoteRefs;
+    std::string mTips;
+    std::vector<std::string> mRefs;
 };
 
 }
@@ -0,0 +1,214 @@
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LINE_X86
+#endif
+
+#include "line.hpp"
+
+namespace LINE
+{
+
+namespace
+{
+
+inline Kind classify(const char *data
+    , std::size_t size) noexcept
+{
+    if(size == 0)
+        return Kind::OTHER;
+
+    switch(data[0])
+    {
+        case('+'):
+            return size >= 4 && std::memcmp(data, "+++ ", 4) == 0
+                ? Kind::DST
+                    : Kind::ADD;
+        case('-'):
+            return size >= 4 && std::memcmp(data, "--- ", 4) == 0
+                ? Kind::SRC
+                    : Kind::SUB;
+        case('@'):
+            return size >= 2 && data[1] == '@'
+                ? Kind::HUNK
+                    : Kind::OTHER;
+        case('\\'):
+            return Kind::NOTE;
+        default:
+            return Kind::OTHER;
+    }
+}
+
+inline void push(std::vector<Line> &lines
+    , const char *data
+    , std::size_t begin
+    , std::size_t end)
+{
+    lines.push_back(Line{begin, end - begin, classify(data + begin, end - begin)});
+}
+
+// mask has a bit for each '\n' in data[base, base + width).
+inline void pushMask(std::vector<Line> &lines
+    , const char *data
+    , std::size_t base
+    , unsigned int mask
+    , std::size_t &begin)
+{
+    while(mask != 0)
+    {
+        std::size_t np = base + __builtin_ctz(mask);
+        push(lines, data, begin, np);
+        begin = np + 1;
+        mask &= mask - 1;
+    }
+}
+
+std::size_t findScalar(const char *data
+    , std::size_t size
+    , std::size_t pos) noexcept
+{
+    const void *p = std::memchr(data + pos, '\n', size - pos);
+    return p != nullptr
+        ? static_cast<const char*>(p) - data
+            : std::string::npos;
+}
+
+void indexScalar(const char *data
+    , std::size_t size
+    , std::vector<Line> &lines
+    , std::size_t &begin
+    , std::size_t pos)
+{
+    for(; pos < size; pos++)
+    {
+        if(data[pos] == '\n')
+        {
+            push(lines, data, begin, pos);
+            begin = pos + 1;
+        }
+    }
+}
+
+#ifdef LINE_X86
+
+std::size_t findSse2(const char *data
+    , std::size_t size
+    , std::size_t pos) noexcept
+{
+    const __m128i nl = _mm_set1_epi8('\n');
+    for(; pos + 16 <= size; pos += 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        unsigned int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(v, nl));
+        if(mask != 0)
+            return pos + __builtin_ctz(mask);
+    }
+
+    return findScalar(data, size, pos);
+}
+
+void indexSse2(const char *data
+    , std::size_t size
+    , std::vector<Line> &lines
+    , std::size_t &begin)
+{
+    const __m128i nl = _mm_set1_epi8('\n');
+    std::size_t pos = 0;
+    for(; pos + 16 <= size; pos += 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        pushMask(lines, data, pos
+            , _mm_movemask_epi8(_mm_cmpeq_epi8(v, nl))
+            , begin);
+    }
+
+    indexScalar(data, size, lines, begin, pos);
+}
+
+__attribute__((target("avx2")))
+std::size_t findAvx2(const char *data
+    , std::size_t size
+    , std::size_t pos) noexcept
+{
+    const __m256i nl = _mm256_set1_epi8('\n');
+    for(; pos + 32 <= size; pos += 32)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        unsigned int mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, nl));
+        if(mask != 0)
+            return pos + __builtin_ctz(mask);
+    }
+
+    return findSse2(data, size, pos);
+}
+
+__attribute__((target("avx2")))
+void indexAvx2(const char *data
+    , std::size_t size
+    , std::vector<Line> &lines
+    , std::size_t &begin)
+{
+    const __m256i nl = _mm256_set1_epi8('\n');
+    std::size_t pos = 0;
+    for(; pos + 32 <= size; pos += 32)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        pushMask(lines, data, pos
+            , _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, nl))
+            , begin);
+    }
+
+    indexScalar(data, size, lines, begin, pos);
+}
+
+bool hasAvx2() noexcept
+{
+    static const bool has = __builtin_cpu_supports("avx2");
+    return has;
+}
+
+#endif
+
+}
+
+std::size_t find(const char *data
+    , std::size_t size
+    , std::size_t pos) noexcept
+{
+    if(pos >= size)
+        return std::string::npos;
+
+#ifdef LINE_X86
+    return hasAvx2()
+        ? findAvx2(data, size, pos)
+            : findSse2(data, size, pos);
+#else
+    return findScalar(data, size, pos);
+#endif
+}
+
+std::vector<Line> index(const char *data
+    , std::size_t size)
+{
+    std::vector<Line> lines;
+    // average line of patch is longer than 32 bytes.
+    lines.reserve(size / 32 + 1);
+
+    std::size_t begin = 0;
+#ifdef LINE_X86
+    if(hasAvx2())
+        indexAvx2(data, size, lines, begin);
+    else
+        indexSse2(data, size, lines, begin);
+#else
+    indexScalar(data, size, lines, begin, 0);
+#endif
+
+    if(begin < size)
+        push(lines, data, begin, size);
+
+    return lines;
+}
+
+}
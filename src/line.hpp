@@ -0,0 +1,58 @@
+#ifndef LINE_HPP
+#define LINE_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace LINE
+{
+
+/* kind of line in output of git show --patch.
+// SRC: "--- ", DST: "+++ ", HUNK: "@@", ADD: '+', SUB: '-',
+// NOTE: '\' (ex. "\ No newline at end of file"), OTHER: otherwise.
+// SRC and DST are only candidates of file header,
+// because removed or added line may start with same characters.
+*/
+enum class Kind : unsigned char
+{
+    OTHER,
+    SRC,
+    DST,
+    HUNK,
+    ADD,
+    SUB,
+    NOTE
+};
+
+// pos and size do not include '\n'.
+struct Line
+{
+    std::size_t pos;
+    std::size_t size;
+    Kind kind;
+};
+
+/* return position of first '\n' in [pos, size).
+// if '\n' is not found, function return std::string::npos.
+// SSE2 or AVX2 is used if it is available, otherwise scalar loop is used.
+*/
+extern std::size_t find(const char *data
+    , std::size_t size
+    , std::size_t pos = 0) noexcept;
+
+/* split data into lines and classify each line in one pass.
+// last line that is not terminated by '\n' is also indexed.
+*/
+extern std::vector<Line> index(const char *data
+    , std::size_t size);
+
+inline std::size_t find(const std::string &src
+    , std::size_t pos = 0) noexcept
+    {return find(src.data(), src.size(), pos);}
+inline std::vector<Line> index(const std::string &src)
+    {return index(src.data(), src.size());}
+
+}
+
+#endif
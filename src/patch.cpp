@@ -0,0 +1,271 @@
+#include <fstream>
+#include <vector>
+#include <utility>
+
+#include "patch.hpp"
+
+namespace PATCH
+{
+
+std::string unquote(const std::string &path)
+{
+    std::string str(path);
+    if(!str.empty() && str.back() == '\t')
+        str.pop_back();
+
+    if(str.size() < 2 || str.front() != '"' || str.back() != '"')
+        return str;
+
+    std::string ret;
+    for(std::size_t i = 1; i + 1 < str.size(); i++)
+    {
+        if(str[i] != '\\' || i + 2 >= str.size())
+        {
+            ret.push_back(str[i]);
+            continue;
+        }
+
+        char c = str[++i];
+        if(c >= '0' && c <= '7')
+        {
+            int value = 0;
+            for(int n = 0; n < 3 && i + 1 < str.size() && str[i] >= '0' && str[i] <= '7'; n++, i++)
+                value = value * 8 + (str[i] - '0');
+            ret.push_back(static_cast<char>(value));
+            i--;
+            continue;
+        }
+
+        switch(c)
+        {
+            case 'a': ret.push_back('\a'); break;
+            case 'b': ret.push_back('\b'); break;
+            case 'f': ret.push_back('\f'); break;
+            case 'n': ret.push_back('\n'); break;
+            case 'r': ret.push_back('\r'); break;
+            case 't': ret.push_back('\t'); break;
+            case 'v': ret.push_back('\v'); break;
+            default: ret.push_back(c); break;
+        }
+    }
+    return ret;
+}
+
+Parser::Parser(std::size_t budget)
+    : mBudget(budget)
+    , mUsed(0)
+    , mIsOversize(false)
+    , mCarry()
+    , mState(State::NONE)
+    , mSrc()
+    , mTree()
+    , mFile()
+    , mHunks()
+    , mHunk()
+    , mSub()
+    , mAdd()
+{
+}
+
+void Parser::feed(const char *data
+    , std::size_t size)
+{
+    if(mIsOversize)
+        return;
+
+    std::size_t pos = 0;
+    if(!mCarry.empty())
+    {
+        std::size_t np = LINE::find(data, size);
+        if(np == std::string::npos)
+        {
+            if(charge(size))
+                mCarry.append(data, size);
+            return;
+        }
+
+        if(!charge(np))
+            return;
+        mCarry.append(data, np);
+
+        // carry is charged while it waits for '\n', and line() charges completed line again.
+        mUsed -= mCarry.size();
+        auto lines = LINE::index(mCarry);
+        line(mCarry.data(), mCarry.size(), lines.empty() ? LINE::Kind::OTHER : lines.front().kind);
+        mCarry.clear();
+        pos = np + 1;
+    }
+
+    // last line that is not terminated by '\n' is kept until next feed().
+    std::size_t end = size;
+    while(end > pos && data[end - 1] != '\n')
+        end--;
+
+    for(auto &&l : LINE::index(data + pos, end - pos))
+    {
+        if(mIsOversize)
+            return;
+        line(data + pos + l.pos, l.size, l.kind);
+    }
+
+    if(end < size && charge(size - end))
+        mCarry.assign(data + end, size - end);
+}
+
+void Parser::finish()
+{
+    if(!mIsOversize && !mCarry.empty())
+    {
+        mUsed -= mCarry.size();
+        auto lines = LINE::index(mCarry);
+        line(mCarry.data(), mCarry.size(), lines.empty() ? LINE::Kind::OTHER : lines.front().kind);
+    }
+    mCarry.clear();
+
+    closeFile();
+}
+
+bool Parser::parse(const std::filesystem::path &file)
+{
+    std::ifstream fstr(file, std::ios::binary);
+    if(!fstr.is_open())
+        return false;
+
+    std::vector<char> buffer(CHUNK_SIZE);
+    while(fstr)
+    {
+        fstr.read(buffer.data(), buffer.size());
+        if(fstr.gcount() > 0)
+            feed(buffer.data(), static_cast<std::size_t>(fstr.gcount()));
+        if(mIsOversize)
+            break;
+    }
+
+    finish();
+    return !fstr.bad();
+}
+
+void Parser::line(const char *data
+    , std::size_t size
+    , LINE::Kind kind)
+{
+    using namespace boost::property_tree;
+
+    if(mState == State::HUNK)
+    {
+        if(kind == LINE::Kind::NOTE)
+            return;
+
+        bool isAdd = kind == LINE::Kind::ADD || kind == LINE::Kind::DST;
+        bool isSub = kind == LINE::Kind::SUB || kind == LINE::Kind::SRC;
+        if(isAdd || isSub)
+        {
+            if(!charge(size + NODE_SIZE))
+                return;
+
+            ptree ele;
+            ele.put("", std::string(data + 1, size - 1));
+            (isAdd ? mAdd : mSub).push_back(std::make_pair("", ele));
+            return;
+        }
+
+        closeHunk();
+        mState = State::FILE;
+    }
+
+    if(mState == State::FILE)
+    {
+        if(kind == LINE::Kind::HUNK)
+        {
+            // function context after second "@@" is not stored, so it is not charged.
+            std::string str(data, size);
+            std::string info(str.substr(0, str.find("@@", 2) + 2));
+            if(!charge(info.size() + NODE_SIZE))
+                return;
+
+            mHunk.put("info", info);
+            mState = State::HUNK;
+            return;
+        }
+
+        closeFile();
+    }
+
+    if(mState == State::HEADER)
+    {
+        if(kind == LINE::Kind::DST)
+        {
+            if(!charge(mSrc.size() + size + NODE_SIZE * 3))
+                return;
+
+            mFile.put("src", unquote(mSrc));
+            mFile.put("dst", unquote(std::string(data + 4, size - 4)));
+            mSrc.clear();
+            mState = State::FILE;
+            return;
+        }
+
+        mSrc.clear();
+        mState = State::NONE;
+    }
+
+    if(kind == LINE::Kind::SRC)
+    {
+        mSrc.assign(data + 4, size - 4);
+        mState = State::HEADER;
+    }
+}
+
+void Parser::closeHunk()
+{
+    if(!mSub.empty())
+        mHunk.add_child("sub", mSub);
+    if(!mAdd.empty())
+        mHunk.add_child("add", mAdd);
+    mHunks.push_back(std::make_pair("", std::move(mHunk)));
+
+    mHunk.clear();
+    mSub.clear();
+    mAdd.clear();
+}
+
+void Parser::closeFile()
+{
+    if(mState == State::HUNK)
+        closeHunk();
+
+    if(mState == State::HUNK || mState == State::FILE)
+    {
+        if(!mHunks.empty())
+            mFile.add_child("hunk", mHunks);
+        mTree.push_back(std::make_pair("", std::move(mFile)));
+    }
+
+    mFile.clear();
+    mHunks.clear();
+    mSrc.clear();
+    mState = State::NONE;
+}
+
+bool Parser::charge(std::size_t size)
+{
+    if(mIsOversize)
+        return false;
+
+    mUsed += size;
+    if(mUsed <= mBudget)
+        return true;
+
+    // keep records completed so far and drop record in progress.
+    mIsOversize = true;
+    mCarry.clear();
+    mSub.clear();
+    mAdd.clear();
+    mHunk.clear();
+    mHunks.clear();
+    mFile.clear();
+    mState = State::NONE;
+    return false;
+}
+
+}
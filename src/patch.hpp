@@ -0,0 +1,88 @@
+#ifndef PATCH_HPP
+#define PATCH_HPP
+
+#include <filesystem>
+#include <string>
+#include <cstddef>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include "line.hpp"
+
+namespace PATCH
+{
+
+/* path of "--- " or "+++ " line as it is in repository.
+// git appends '\t' to path that contains space, and quotes path that contains
+// special or non-ASCII characters like C string literal ("\303\274.txt").
+*/
+extern std::string unquote(const std::string &path);
+
+/* incremental parser of git show --patch --unified=0.
+// output of git show is given by feed() in chunks of any size,
+// and each line is converted to file and hunk record as soon as it is complete.
+// if estimated size of records exceeds budget, parser stops storing records,
+// and isOversize() returns true. remaining input is read and ignored.
+// budget is approximate: it counts data stored in records and NODE_SIZE per node,
+// and not input that is not stored (e.g. function context of hunk header)
+// or JSON made from records later by serialize().
+*/
+class Parser
+{
+public:
+    explicit Parser(std::size_t budget);
+
+    void feed(const char *data
+        , std::size_t size);
+    void finish();
+
+    // read file in chunks of CHUNK_SIZE bytes.
+    bool parse(const std::filesystem::path &file);
+
+    bool isOversize() const noexcept
+        {return mIsOversize;}
+    // estimated size of records. it includes record that exceeded budget.
+    std::size_t used() const noexcept
+        {return mUsed;}
+    boost::property_tree::ptree &tree() noexcept
+        {return mTree;}
+
+    inline static const std::size_t CHUNK_SIZE = 64 * 1024;
+    // approximate size of one ptree node excluding its data.
+    inline static const std::size_t NODE_SIZE = sizeof(boost::property_tree::ptree) + 64;
+
+private:
+    enum class State : unsigned char
+    {
+        NONE,
+        HEADER,
+        FILE,
+        HUNK
+    };
+
+    void line(const char *data
+        , std::size_t size
+        , LINE::Kind kind);
+    void closeHunk();
+    void closeFile();
+    bool charge(std::size_t size);
+
+    std::size_t mBudget;
+    std::size_t mUsed;
+    bool mIsOversize;
+
+    std::string mCarry;
+    State mState;
+    std::string mSrc;
+
+    boost::property_tree::ptree mTree;
+    boost::property_tree::ptree mFile;
+    boost::property_tree::ptree mHunks;
+    boost::property_tree::ptree mHunk;
+    boost::property_tree::ptree mSub;
+    boost::property_tree::ptree mAdd;
+};
+
+}
+
+#endif
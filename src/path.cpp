@@ -1,6 +1,7 @@
 #include <fstream>
 #include <sstream>
 
+#include "line.hpp"
 #include "path.hpp"
 
 namespace PATH
@@ -40,7 +41,7 @@ std::string::size_type getLine(const std::string &src
 {
     if(pos < src.size())
     {
-        std::string::size_type np = src.find('\n', pos);
+        std::string::size_type np = LINE::find(src, pos);
         dst = src.substr(pos, np - pos);
         return np != std::string::npos
             ? np + 1
@@ -0,0 +1,239 @@
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+namespace PIPELINE
+{
+
+/* bounded queue between two stages.
+// push() blocks while queue is full (backpressure),
+// pop() blocks while queue is empty and is not closed.
+// after close(), push() fails and pop() fails once queue is empty.
+*/
+template<class T>
+class Queue
+{
+public:
+    explicit Queue(std::size_t capacity)
+        : mMutex()
+        , mNotFull()
+        , mNotEmpty()
+        , mQueue()
+        , mCapacity(capacity != 0 ? capacity : 1)
+        , mIsClosed(false)
+        , mPeak(0)
+        , mPushed(0)
+        , mOccupancy(0)
+        , mBlocked(0){}
+
+    bool push(T &&value)
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        if(!mIsClosed && mQueue.size() >= mCapacity)
+        {
+            mBlocked++;
+            mNotFull.wait(lock, [&]{return mIsClosed || mQueue.size() < mCapacity;});
+        }
+        if(mIsClosed)
+            return false;
+
+        mQueue.push_back(std::move(value));
+        mPushed++;
+        mOccupancy += mQueue.size();
+        if(mQueue.size() > mPeak)
+            mPeak = mQueue.size();
+
+        lock.unlock();
+        mNotEmpty.notify_one();
+        return true;
+    }
+
+    bool pop(T &value)
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mNotEmpty.wait(lock, [&]{return mIsClosed || !mQueue.empty();});
+        if(mQueue.empty())
+            return false;
+
+        value = std::move(mQueue.front());
+        mQueue.pop_front();
+
+        lock.unlock();
+        mNotFull.notify_one();
+        return true;
+    }
+
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mIsClosed = true;
+        }
+        mNotFull.notify_all();
+        mNotEmpty.notify_all();
+    }
+
+    std::size_t capacity() const noexcept
+        {return mCapacity;}
+    std::size_t size() const
+        {std::lock_guard<std::mutex> lock(mMutex); return mQueue.size();}
+    // maximum number of elements at same time.
+    std::size_t peak() const
+        {std::lock_guard<std::mutex> lock(mMutex); return mPeak;}
+    std::size_t pushed() const
+        {std::lock_guard<std::mutex> lock(mMutex); return mPushed;}
+    // number of push() that waited for free space.
+    std::size_t blocked() const
+        {std::lock_guard<std::mutex> lock(mMutex); return mBlocked;}
+    // average number of elements just after push().
+    double average() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mPushed != 0
+            ? static_cast<double>(mOccupancy) / mPushed
+                : 0.0;
+    }
+
+private:
+    mutable std::mutex mMutex;
+    std::condition_variable mNotFull;
+    std::condition_variable mNotEmpty;
+    std::deque<T> mQueue;
+    std::size_t mCapacity;
+    bool mIsClosed;
+
+    std::size_t mPeak;
+    std::size_t mPushed;
+    std::size_t mOccupancy;
+    std::size_t mBlocked;
+};
+
+/* bytes shared by elements in flight between stages.
+// acquire() blocks while acquired bytes would exceed capacity.
+// if nothing is acquired, acquire() never blocks,
+// so that element larger than capacity is still processed alone.
+*/
+class Budget
+{
+public:
+    explicit Budget(std::size_t capacity)
+        : mMutex()
+        , mReleased()
+        , mCapacity(capacity)
+        , mUsed(0)
+        , mPeak(0)
+        , mBlocked(0){}
+
+    void acquire(std::size_t size)
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        if(mUsed != 0 && mUsed + size > mCapacity)
+        {
+            mBlocked++;
+            mReleased.wait(lock, [&]{return mUsed == 0 || mUsed + size <= mCapacity;});
+        }
+
+        mUsed += size;
+        if(mUsed > mPeak)
+            mPeak = mUsed;
+    }
+
+    void release(std::size_t size)
+    {
+        if(size == 0)
+            return;
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mUsed -= size;
+        }
+        mReleased.notify_all();
+    }
+
+    std::size_t capacity() const noexcept
+        {return mCapacity;}
+    // maximum number of bytes acquired at same time.
+    std::size_t peak() const
+        {std::lock_guard<std::mutex> lock(mMutex); return mPeak;}
+    // number of acquire() that waited for release().
+    std::size_t blocked() const
+        {std::lock_guard<std::mutex> lock(mMutex); return mBlocked;}
+
+private:
+    mutable std::mutex mMutex;
+    std::condition_variable mReleased;
+    std::size_t mCapacity;
+    std::size_t mUsed;
+
+    std::size_t mPeak;
+    std::size_t mBlocked;
+};
+
+/* run func on n threads.
+// each thread pops element from in and calls func(element).
+// if func returns true, element is pushed to out.
+// out is closed after all threads are finished.
+// returned thread must be joined.
+*/
+template<class T, class Func>
+std::thread stage(std::size_t n
+    , Queue<T> &in
+    , Queue<T> &out
+    , Func func)
+{
+    return std::thread([n, &in, &out, func]
+        {
+            std::vector<std::thread> workers;
+            for(std::size_t i = 0; i < (n != 0 ? n : 1); i++)
+            {
+                workers.emplace_back([&]
+                    {
+                        T value;
+                        while(in.pop(value))
+                        {
+                            if(func(value))
+                                out.push(std::move(value));
+                        }
+                    });
+            }
+
+            for(auto &&t : workers)
+                t.join();
+            out.close();
+        });
+}
+
+// last stage of pipeline.
+template<class T, class Func>
+std::thread stage(std::size_t n
+    , Queue<T> &in
+    , Func func)
+{
+    return std::thread([n, &in, func]
+        {
+            std::vector<std::thread> workers;
+            for(std::size_t i = 0; i < (n != 0 ? n : 1); i++)
+            {
+                workers.emplace_back([&]
+                    {
+                        T value;
+                        while(in.pop(value))
+                            func(value);
+                    });
+            }
+
+            for(auto &&t : workers)
+                t.join();
+        });
+}
+
+}
+
+#endif
@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+#include <system_error>
+
+#include "path.hpp"
+#include "seen.hpp"
+
+namespace SEEN
+{
+
+Set::Set()
+    : mMutex()
+    , mCapacity(0)
+    , mBits()
+    , mExact()
+{
+    resize(MIN_CAPACITY);
+}
+
+bool Set::load(const std::filesystem::path &file)
+{
+    std::ifstream fstr(file);
+    if(!fstr.is_open())
+        return false;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::string line;
+    Digest digest;
+    while(std::getline(fstr, line))
+    {
+        if(toDigest(line, digest))
+            mExact.insert(digest);
+    }
+
+    resize(mExact.size() * 2);
+    return true;
+}
+
+bool Set::save(const std::filesystem::path &file
+    , const std::filesystem::path &tmp) const
+{
+    if(!PATH::isValid(file))
+        return false;
+
+    // file is replaced at once, so that interrupted save keeps previous set.
+    {
+        std::ofstream fstr(tmp);
+        if(!fstr.is_open())
+            return false;
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        for(auto &&d : mExact)
+            fstr << toHash(d) << '\n';
+        if(!fstr)
+            return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmp, file, ec);
+    return !ec;
+}
+
+bool Set::contains(const std::string &hash) const
+{
+    Digest digest;
+    if(!toDigest(hash, digest))
+        return false;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    return test(digest) && mExact.count(digest) != 0;
+}
+
+void Set::insert(const std::string &hash)
+{
+    Digest digest;
+    if(!toDigest(hash, digest))
+        return;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if(!mExact.insert(digest).second)
+        return;
+
+    if(mExact.size() > mCapacity)
+        resize(mCapacity * 2);
+    else
+        set(digest);
+}
+
+bool Set::empty() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mExact.empty();
+}
+
+std::size_t Set::DigestHash::operator()(const Digest &d) const noexcept
+{
+    std::size_t h;
+    std::memcpy(&h, d.data(), sizeof(h));
+    return h;
+}
+
+bool Set::toDigest(const std::string &hash
+    , Digest &digest) noexcept
+{
+    if(hash.size() != digest.size() * 2)
+        return false;
+
+    auto &&hex = [](char c)
+        {
+            return c >= '0' && c <= '9' ? c - '0'
+                : c >= 'a' && c <= 'f' ? c - 'a' + 10
+                    : -1;
+        };
+    for(std::size_t i = 0; i < digest.size(); i++)
+    {
+        int hi = hex(hash[i * 2]), lo = hex(hash[i * 2 + 1]);
+        if(hi < 0 || lo < 0)
+            return false;
+        digest[i] = static_cast<unsigned char>(hi << 4 | lo);
+    }
+    return true;
+}
+
+std::string Set::toHash(const Digest &digest)
+{
+    static const char *HEX = "0123456789abcdef";
+    std::string hash;
+    for(unsigned char c : digest)
+    {
+        hash.push_back(HEX[c >> 4]);
+        hash.push_back(HEX[c & 0xf]);
+    }
+    return hash;
+}
+
+// filter is rebuilt from exact set whenever capacity is exceeded.
+void Set::resize(std::size_t capacity)
+{
+    mCapacity = std::max(capacity, MIN_CAPACITY);
+    mBits.assign((mCapacity * BITS_PER_ELEMENT + 63) / 64, 0);
+    for(auto &&d : mExact)
+        set(d);
+}
+
+/* digest is already uniform, so two words of it are used as hashes
+// of double hashing (h1 + i * h2) instead of hashing it again.
+*/
+void Set::set(const Digest &digest) noexcept
+{
+    std::uint64_t h1, h2, size = mBits.size() * 64;
+    std::memcpy(&h1, digest.data(), sizeof(h1));
+    std::memcpy(&h2, digest.data() + 8, sizeof(h2));
+    for(std::size_t i = 0; i < PROBES; i++)
+    {
+        std::uint64_t bit = (h1 + i * h2) % size;
+        mBits[bit / 64] |= std::uint64_t(1) << (bit % 64);
+    }
+}
+
+bool Set::test(const Digest &digest) const noexcept
+{
+    std::uint64_t h1, h2, size = mBits.size() * 64;
+    std::memcpy(&h1, digest.data(), sizeof(h1));
+    std::memcpy(&h2, digest.data() + 8, sizeof(h2));
+    for(std::size_t i = 0; i < PROBES; i++)
+    {
+        std::uint64_t bit = (h1 + i * h2) % size;
+        if((mBits[bit / 64] & std::uint64_t(1) << (bit % 64)) == 0)
+            return false;
+    }
+    return true;
+}
+
+}
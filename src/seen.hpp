@@ -0,0 +1,65 @@
+#ifndef SEEN_HPP
+#define SEEN_HPP
+
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include <array>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+namespace SEEN
+{
+
+/* set of commits whose record was written.
+// Bloom filter answers most lookups of new commits without touching exact set,
+// and exact set removes false positives, so contains() never errs.
+// file has one hash (40 hex digits) per line.
+// insert() and contains() may be called from multiple threads.
+*/
+class Set
+{
+public:
+    Set();
+
+    bool load(const std::filesystem::path &file);
+    // set is written to tmp, and tmp is renamed to file.
+    bool save(const std::filesystem::path &file
+        , const std::filesystem::path &tmp) const;
+
+    bool contains(const std::string &hash) const;
+    void insert(const std::string &hash);
+
+    bool empty() const;
+
+private:
+    using Digest = std::array<unsigned char, 20>;
+    struct DigestHash
+    {
+        std::size_t operator()(const Digest &d) const noexcept;
+    };
+
+    static bool toDigest(const std::string &hash
+        , Digest &digest) noexcept;
+    static std::string toHash(const Digest &digest);
+
+    void resize(std::size_t capacity);
+    void set(const Digest &digest) noexcept;
+    bool test(const Digest &digest) const noexcept;
+
+    // about 1% false positive rate.
+    inline static const std::size_t BITS_PER_ELEMENT = 10;
+    inline static const std::size_t PROBES = 7;
+    inline static const std::size_t MIN_CAPACITY = 1 << 16;
+
+    mutable std::mutex mMutex;
+    std::size_t mCapacity;
+    std::vector<std::uint64_t> mBits;
+    std::unordered_set<Digest, DigestHash> mExact;
+};
+
+}
+
+#endif
@@ -0,0 +1,106 @@
+#include <chrono>
+#include <fstream>
+#include <system_error>
+
+#include "path.hpp"
+#include "shard.hpp"
+
+namespace SHARD
+{
+
+namespace
+{
+
+long long now()
+{
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+std::filesystem::path leaseFile(const std::filesystem::path &dir
+    , int instance)
+{
+    return dir / (std::to_string(instance) + ".lease");
+}
+
+}
+
+std::uint64_t hash(const std::string &str) noexcept
+{
+    std::uint64_t h = 14695981039346656037ULL;
+    for(unsigned char c : str)
+    {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+
+    // FNV-1a of short similar strings are close to each other,
+    // so bits are mixed to spread points on ring.
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+Ring::Ring(const std::vector<int> &instances
+    , int vnodes)
+    : mPoints()
+{
+    for(int instance : instances)
+    {
+        for(int i = 0; i < vnodes; i++)
+            mPoints.emplace(hash(std::to_string(instance) + "#" + std::to_string(i)), instance);
+    }
+}
+
+int Ring::owner(const std::string &name) const
+{
+    if(mPoints.empty())
+        return -1;
+
+    auto iter = mPoints.lower_bound(hash(name));
+    return iter != mPoints.end()
+        ? iter->second
+            : mPoints.begin()->second;
+}
+
+bool renew(const std::filesystem::path &dir
+    , int instance)
+{
+    if(!PATH::isValid(dir, std::filesystem::file_type::directory))
+        return false;
+
+    // lease is replaced at once, so that other instance never reads half of it.
+    std::filesystem::path file(leaseFile(dir, instance));
+    std::filesystem::path tmp(file.string() + ".tmp");
+    {
+        std::ofstream fstr(tmp);
+        if(!fstr.is_open())
+            return false;
+        fstr << now() << '\n';
+        if(!fstr)
+            return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmp, file, ec);
+    return !ec;
+}
+
+bool isAlive(const std::filesystem::path &dir
+    , int instance
+    , long long duration)
+{
+    std::string str(PATH::read(leaseFile(dir, instance)));
+    if(str.empty())
+        return false;
+
+    try
+        {return now() - std::stoll(str) <= duration;}
+    catch(const std::exception &e)
+        {return false;}
+}
+
+}
@@ -0,0 +1,45 @@
+#ifndef SHARD_HPP
+#define SHARD_HPP
+
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+
+namespace SHARD
+{
+
+// FNV-1a with finalizer of MurmurHash3. result is same on every host.
+extern std::uint64_t hash(const std::string &str) noexcept;
+
+/* consistent hash ring of collector instances.
+// each instance has vnodes points on ring, and repository is owned by
+// instance of first point at or after hash of repository name.
+// if instance disappears, only repositories owned by it move to other instances.
+*/
+class Ring
+{
+public:
+    Ring(const std::vector<int> &instances
+        , int vnodes);
+
+    int owner(const std::string &name) const;
+
+private:
+    std::map<std::uint64_t, int> mPoints;
+};
+
+/* file-based lease of instance.
+// <dir>/<instance>.lease holds time (seconds since epoch) of last renew().
+// instance is alive if its lease was renewed within duration seconds.
+*/
+extern bool renew(const std::filesystem::path &dir
+    , int instance);
+extern bool isAlive(const std::filesystem::path &dir
+    , int instance
+    , long long duration);
+
+}
+
+#endif
@@ -5,6 +5,8 @@
 #include <string>
 #include <cstdlib>
 
+#include "trace.hpp"
+
 namespace SYSTEM
 {
 
@@ -19,11 +21,17 @@ std::string command(Str &&str, Args&&... args)
     return ret;
 }
 
-int system(const std::string &cmd)
-    {return std::system(cmd.c_str());}
+inline int system(const std::string &cmd)
+{
+    TRACE::Span span("system", "system", cmd);
+    return std::system(cmd.c_str());
+}
 template<class... Args>
 int system(Args&&... cmds)
-    {return std::system(command(std::forward<Args>(cmds)...).c_str());}
+{
+    const std::string cmd(command(std::forward<Args>(cmds)...));
+    return system(cmd);
+}
 
 }
 
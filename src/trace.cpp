@@ -0,0 +1,183 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <unistd.h>
+
+#include "path.hpp"
+#include "trace.hpp"
+
+namespace TRACE
+{
+
+namespace
+{
+
+struct Event
+{
+    const char *category;
+    const char *name;
+    std::string detail;
+    long long begin;
+    long long duration;
+};
+
+// mutex of buffer is locked only by its thread and write(), so it is almost never contended.
+struct Buffer
+{
+    std::mutex mutex;
+    int tid = 0;
+    std::vector<Event> events;
+};
+
+std::atomic<bool> isEnabledFlag(false);
+std::chrono::steady_clock::time_point origin;
+
+std::mutex buffersMutex;
+std::vector<std::shared_ptr<Buffer>> buffers;
+int nextTid = 1;
+
+// microseconds since enable().
+long long now()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - origin).count();
+}
+
+Buffer &buffer()
+{
+    thread_local std::shared_ptr<Buffer> local;
+    if(!local)
+    {
+        local = std::make_shared<Buffer>();
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        local->tid = nextTid++;
+        buffers.push_back(local);
+    }
+    return *local;
+}
+
+void escape(std::ostream &ostr
+    , const std::string &str)
+{
+    static const char *HEX = "0123456789abcdef";
+    for(unsigned char c : str)
+    {
+        if(c == '"' || c == '\\')
+            ostr << '\\' << c;
+        else if(c < 0x20)
+            ostr << "\\u00" << HEX[c >> 4] << HEX[c & 0xf];
+        else
+            ostr << c;
+    }
+}
+
+}
+
+void enable()
+{
+    if(isEnabledFlag.load(std::memory_order_relaxed))
+        return;
+
+    origin = std::chrono::steady_clock::now();
+    isEnabledFlag.store(true, std::memory_order_release);
+}
+
+bool isEnabled() noexcept
+{
+    return isEnabledFlag.load(std::memory_order_acquire);
+}
+
+bool write(const std::filesystem::path &file)
+{
+    if(!PATH::isValid(file))
+        return false;
+
+    std::ofstream fstr(file);
+    if(!fstr.is_open())
+        return false;
+
+    int pid = static_cast<int>(getpid());
+    bool isFirst = true;
+    fstr << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    for(auto &&b : buffers)
+    {
+        std::lock_guard<std::mutex> block(b->mutex);
+        for(auto &&e : b->events)
+        {
+            fstr << (isFirst ? "\n" : ",\n")
+                << "{\"ph\":\"X\",\"pid\":" << pid
+                << ",\"tid\":" << b->tid
+                << ",\"ts\":" << e.begin
+                << ",\"dur\":" << e.duration
+                << ",\"cat\":\"" << e.category
+                << "\",\"name\":\"" << e.name << "\"";
+            if(!e.detail.empty())
+            {
+                fstr << ",\"args\":{\"detail\":\"";
+                escape(fstr, e.detail);
+                fstr << "\"}";
+            }
+            fstr << "}";
+            isFirst = false;
+        }
+        b->events.clear();
+    }
+
+    // buffer whose thread has exited is referred only from here.
+    buffers.erase(std::remove_if(buffers.begin(), buffers.end()
+        , [](const std::shared_ptr<Buffer> &b){return b.use_count() == 1;})
+        , buffers.end());
+
+    fstr << "\n]}\n";
+    fstr.close();
+    return static_cast<bool>(fstr);
+}
+
+Span::Span(const char *category
+    , const char *name)
+    : mCategory(category)
+    , mName(name)
+    , mDetail()
+    , mBegin(isEnabled() ? now() : -1)
+{
+}
+
+Span::Span(const char *category
+    , const char *name
+    , const std::string &detail)
+    : mCategory(category)
+    , mName(name)
+    , mDetail(isEnabled() ? detail : std::string())
+    , mBegin(isEnabled() ? now() : -1)
+{
+}
+
+Span::Span(const char *category
+    , const char *name
+    , const std::filesystem::path &detail)
+    : mCategory(category)
+    , mName(name)
+    , mDetail(isEnabled() ? detail.string() : std::string())
+    , mBegin(isEnabled() ? now() : -1)
+{
+}
+
+Span::~Span()
+{
+    if(mBegin < 0)
+        return;
+
+    long long end = now();
+    Buffer &b = buffer();
+    std::lock_guard<std::mutex> lock(b.mutex);
+    b.events.push_back(Event{mCategory, mName, std::move(mDetail), mBegin, end - mBegin});
+}
+
+}
@@ -0,0 +1,51 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <filesystem>
+#include <string>
+
+namespace TRACE
+{
+
+/* tracer of execution timeline.
+// spans are recorded only after enable(), otherwise Span costs one flag check.
+// each thread appends events to its own buffer, and write() outputs
+// events of all threads as Chrome trace-event JSON (chrome://tracing, Perfetto).
+*/
+extern void enable();
+extern bool isEnabled() noexcept;
+
+// write recorded events to file and discard them.
+extern bool write(const std::filesystem::path &file);
+
+/* complete event from construction to destruction.
+// category and name must be string literals.
+// detail (repository path, commit hash, command, ...) is shown as argument.
+// detail is copied, and path is converted to string, only if tracing is enabled.
+*/
+class Span
+{
+public:
+    Span(const char *category
+        , const char *name);
+    Span(const char *category
+        , const char *name
+        , const std::string &detail);
+    Span(const char *category
+        , const char *name
+        , const std::filesystem::path &detail);
+    ~Span();
+
+    Span(const Span&) = delete;
+    Span &operator=(const Span&) = delete;
+
+private:
+    const char *mCategory;
+    const char *mName;
+    std::string mDetail;
+    long long mBegin;
+};
+
+}
+
+#endif
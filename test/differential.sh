@@ -0,0 +1,98 @@
+#!/bin/sh
+# differential test of diff engines.
+# runs collector with "git" and "native" diff_engine over same repositories
+# and compares JSON of every commit.
+# it is run with commit.memory_budget of configure.json and with SMALL_BUDGET,
+# so that engines are also compared when commits are truncated.
+# usage: test/differential.sh [repository url]...
+# without url, fixture repository that contains renamed, deleted and
+# quoted paths (space, non-ASCII), empty commit, commit of many files and
+# hunks with function context is created and used.
+
+set -e
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+COLLECTOR="$ROOT/collector"
+WORK=$(mktemp -d)
+SMALL_BUDGET=200000
+trap 'rm -rf "$WORK"' EXIT
+
+if [ ! -x "$COLLECTOR" ]; then
+    echo "differential: $COLLECTOR is not built" >&2
+    exit 1
+fi
+
+if [ $# -eq 0 ]; then
+    FIXTURE="$WORK/fixture"
+    git init -q "$FIXTURE"
+    cd "$FIXTURE"
+    git config user.name differential
+    git config user.email differential@localhost
+    printf 'a\nb\nc\n' > plain.txt
+    printf 'space\n' > 'sp ace.txt'
+    printf 'unicode\n' > "$(printf '\303\274.txt')"
+    printf 'tab\n' > "$(printf 'ta\tb.txt')"
+    git add -A && git commit -q -m 'add files'
+    printf 'a\nB\nc\nd\n' > plain.txt
+    printf 'space\nmore\n' > 'sp ace.txt'
+    git add -A && git commit -q -m 'modify files'
+    git mv plain.txt 'mo ved.txt'
+    git rm -q "$(printf '\303\274.txt')"
+    git commit -q -m 'rename and delete'
+    git commit -q --allow-empty -m 'empty'
+    for i in $(seq 1 20); do seq 1 300 > "many$i.txt"; done
+    git add -A && git commit -q -m 'add many files'
+    for i in $(seq 1 20); do seq 1 2 300 > "many$i.txt"; done
+    git add -A && git commit -q -m 'modify many files'
+    # hunks of C files have function context after second "@@" of their header.
+    for i in $(seq 1 30); do
+        awk -v r=0 'BEGIN {for(f = 1; f <= 40; f++) printf "int function_with_long_name_for_hunk_header_context_%d(void)\n{\n    return %d;\n}\n", f, f + r}' > "func$i.c"
+    done
+    git add -A && git commit -q -m 'add functions'
+    for i in $(seq 1 30); do
+        awk -v r=1 'BEGIN {for(f = 1; f <= 40; f++) printf "int function_with_long_name_for_hunk_header_context_%d(void)\n{\n    return %d;\n}\n", f, f + r}' > "func$i.c"
+    done
+    git add -A && git commit -q -m 'modify functions'
+    set -- "file://$FIXTURE"
+fi
+
+cd "$WORK"
+python3 - "$@" <<'PY'
+import json, sys
+repositories = [{"name": "r%d" % i, "url": url} for i, url in enumerate(sys.argv[1:])]
+json.dump({"repositories": repositories}, open("repositories.json", "w"))
+PY
+
+for BUDGET in default $SMALL_BUDGET; do
+    for ENGINE in git native; do
+        mkdir -p "$WORK/$BUDGET/$ENGINE"
+        python3 - "$ROOT/configure.json" "$WORK/$BUDGET/$ENGINE/configure.json" "$ENGINE" "$BUDGET" <<'PY'
+import json, sys
+configure = json.load(open(sys.argv[1]))
+configure["repositories_json_file"] = "../../repositories.json"
+configure["diff_engine"] = sys.argv[3]
+configure["probe"]["enabled"] = False
+configure["maintenance"]["enabled"] = False
+if sys.argv[4] != "default":
+    configure["commit"]["memory_budget"] = int(sys.argv[4])
+json.dump(configure, open(sys.argv[2], "w"), indent=4)
+PY
+        (cd "$WORK/$BUDGET/$ENGINE" && "$COLLECTOR" > log.txt 2>&1) || {
+            cat "$WORK/$BUDGET/$ENGINE/log.txt" >&2
+            exit 1
+        }
+    done
+
+    COUNT=$(find "$WORK/$BUDGET/git/difference" -name '*.json' | wc -l)
+    if [ "$COUNT" -eq 0 ]; then
+        echo "differential: no commit is collected" >&2
+        exit 1
+    fi
+
+    if diff -r -x '.*' "$WORK/$BUDGET/git/difference" "$WORK/$BUDGET/native/difference"; then
+        echo "differential: $COUNT commits are identical (budget: $BUDGET)"
+    else
+        echo "differential: engines differ (budget: $BUDGET)" >&2
+        exit 1
+    fi
+done
@@ -0,0 +1,206 @@
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include <cstdlib>
+
+#include <unistd.h>
+
+#include "feed.hpp"
+
+/* check of FEED::Writer and FEED::Reader.
+// entries are written and read back, reading is resumed from saved offset,
+// half-written and malformed lines are handled, writers sharing file continue seq,
+// and saved cursor is detected as reset after feed is created again.
+// usage: make feedtest
+*/
+
+namespace
+{
+
+int failures = 0;
+
+void check(bool condition
+    , const char *what)
+{
+    if(!condition)
+    {
+        std::cerr << "feed check failed: " << what << std::endl;
+        failures++;
+    }
+}
+
+bool append(FEED::Writer &writer
+    , int first
+    , int last
+    , const std::string &repository = "repository")
+{
+    for(int i = first; i <= last; i++)
+    {
+        if(!writer.append(repository, "hash" + std::to_string(i), repository + "/hash" + std::to_string(i) + ".json"))
+            return false;
+    }
+    return true;
+}
+
+}
+
+int main()
+{
+    std::filesystem::path dir(std::filesystem::temp_directory_path() / ("feed_check_" + std::to_string(::getpid())));
+    std::filesystem::create_directories(dir);
+    std::filesystem::path file(dir / ".feed");
+
+    {
+        FEED::Writer writer;
+        check(writer.open(file), "open new file");
+        check(append(writer, 1, 10), "append 10 entries");
+    }
+
+    std::uint64_t offset = 0;
+    {
+        FEED::Reader reader(file);
+        FEED::Entry entry;
+        int count = 0;
+        while(count < 4 && reader.next(entry))
+        {
+            count++;
+            check(entry.seq == static_cast<std::uint64_t>(count), "seq of read entry");
+            check(entry.hash == "hash" + std::to_string(count), "hash of read entry");
+        }
+        check(count == 4, "read 4 entries");
+        offset = reader.offset();
+    }
+
+    // writer reopened after crash removes half-written line and continues seq.
+    {
+        std::ofstream fstr(file, std::ios::app);
+        fstr << "11\trepository\thash";
+    }
+    {
+        FEED::Writer writer;
+        check(writer.open(file), "reopen file");
+        check(append(writer, 11, 12), "append 2 entries");
+    }
+
+    // malformed line is skipped.
+    {
+        std::ofstream fstr(file, std::ios::app);
+        fstr << "malformed\n";
+    }
+    {
+        FEED::Writer writer;
+        check(writer.open(file), "reopen file after malformed line");
+        check(append(writer, 13, 13), "append after malformed line");
+    }
+
+    {
+        FEED::Reader reader(file, offset);
+        FEED::Entry entry;
+        std::uint64_t expected = 5;
+        while(reader.next(entry))
+        {
+            check(entry.seq == expected, "seq of resumed entry");
+            check(entry.hash == "hash" + std::to_string(expected), "hash of resumed entry");
+            expected++;
+        }
+        check(expected == 14, "resume from saved offset");
+
+        // entry appended after end of file is read by same reader.
+        {
+            std::ofstream fstr(file, std::ios::app);
+            fstr << "14\trepository\thash14\trepos";
+        }
+        check(!reader.next(entry), "half-written line is not read");
+        {
+            std::ofstream fstr(file, std::ios::app);
+            fstr << "itory/hash14.json\n";
+        }
+        check(reader.next(entry) && entry.seq == 14, "line completed later is read");
+        check(reader.offset() == std::filesystem::file_size(file), "offset at end of file");
+    }
+
+    // each writer reads tail again after other writer has appended.
+    {
+        std::filesystem::path shared(dir / ".shared");
+        FEED::Writer first, second;
+        check(first.open(shared) && second.open(shared), "open shared file");
+        check(append(first, 1, 2), "append by first writer");
+        check(append(second, 3, 3), "append by second writer");
+        check(append(first, 4, 5), "append by first writer again");
+
+        FEED::Reader reader(shared);
+        FEED::Entry entry;
+        std::uint64_t expected = 1;
+        while(reader.next(entry))
+        {
+            check(entry.seq == expected, "seq of shared file");
+            expected++;
+        }
+        check(expected == 6, "read entries of shared file");
+    }
+
+    // feed created again after its directory was removed invalidates saved cursor.
+    {
+        std::filesystem::path recreated(dir / "recreated" / ".feed");
+        std::uint64_t saved = 0, seq = 0;
+        {
+            FEED::Writer writer;
+            check(writer.open(recreated) && append(writer, 1, 30), "append before removal");
+            FEED::Reader reader(recreated);
+            FEED::Entry entry;
+            while(reader.next(entry));
+            saved = reader.offset();
+            seq = reader.seq();
+            check(seq == 30, "seq of saved cursor");
+        }
+
+        std::filesystem::remove_all(recreated.parent_path());
+        {
+            FEED::Writer writer;
+            check(writer.open(recreated) && append(writer, 1, 2, "r0"), "append after removal");
+        }
+        {
+            FEED::Reader reader(recreated, saved, seq);
+            FEED::Entry entry;
+            check(!reader.next(entry) && reader.isReset(), "offset past end of file is reset");
+        }
+
+        // saved offset is now in middle of line.
+        {
+            FEED::Writer writer;
+            check(writer.open(recreated) && append(writer, 3, 80, "r0"), "append until offset is reached");
+        }
+        {
+            FEED::Reader reader(recreated, saved, seq);
+            FEED::Entry entry;
+            check(!reader.next(entry) && reader.isReset(), "offset in middle of line is reset");
+        }
+
+        // offset at start of line, but seq does not continue.
+        std::uint64_t boundary = 0;
+        {
+            FEED::Reader reader(recreated);
+            FEED::Entry entry;
+            for(int i = 0; i < 3 && reader.next(entry); i++);
+            boundary = reader.offset();
+        }
+        {
+            FEED::Reader reader(recreated, boundary, seq);
+            FEED::Entry entry;
+            check(!reader.next(entry) && reader.isReset(), "discontinuous seq is reset");
+        }
+        {
+            FEED::Reader reader(recreated, boundary, 3);
+            FEED::Entry entry;
+            check(reader.next(entry) && entry.seq == 4 && !reader.isReset(), "continuous seq is read");
+        }
+    }
+
+    std::filesystem::remove_all(dir);
+
+    if(failures != 0)
+        return EXIT_FAILURE;
+    std::cout << "feed check passed" << std::endl;
+    return EXIT_SUCCESS;
+}
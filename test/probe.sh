@@ -0,0 +1,95 @@
+#!/bin/sh
+# test of remote change probe.
+# runs collector cycles against file:// remote with trace_file enabled,
+# and checks spans of the cycles: second cycle skips pull, log and diff of
+# unchanged repository, third cycle processes it again after refs are added
+# to repositories.json, and fourth cycle processes it after new commit.
+# usage: test/probe.sh
+
+set -e
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+COLLECTOR="$ROOT/collector"
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+if [ ! -x "$COLLECTOR" ]; then
+    echo "probe: $COLLECTOR is not built" >&2
+    exit 1
+fi
+
+REMOTE="$WORK/remote"
+git init -q "$REMOTE"
+cd "$REMOTE"
+git config user.name probe
+git config user.email probe@localhost
+printf 'a\n' > file.txt
+git add -A && git commit -q -m 'first'
+git checkout -q -b feature
+printf 'feature\n' > feature.txt
+git add -A && git commit -q -m 'feature'
+git checkout -q -
+
+mkdir -p "$WORK/collector"
+cd "$WORK/collector"
+python3 - "$ROOT/configure.json" "file://$REMOTE" <<'PY'
+import json, sys
+configure = json.load(open(sys.argv[1]))
+configure["trace_file"] = "./trace.json"
+configure["probe"]["enabled"] = True
+configure["maintenance"]["enabled"] = False
+json.dump(configure, open("configure.json", "w"), indent=4)
+json.dump({"repositories": [{"name": "r0", "url": sys.argv[2]}]}, open("repositories.json", "w"))
+PY
+
+# cycle CYCLE EXPECTED: run one cycle, and check whether pull, log and diff of r0 ran.
+cycle()
+{
+    "$COLLECTOR" > "log$1.txt" 2>&1 || {
+        cat "log$1.txt" >&2
+        exit 1
+    }
+    python3 - trace.json "$1" "$2" <<'PY'
+import json, sys
+events = json.load(open(sys.argv[1]))["traceEvents"]
+names = {e["name"] for e in events
+    if e["cat"] == "git" and e.get("args", {}).get("detail", "").endswith("/r0")}
+if "probe" not in names:
+    sys.exit("probe: cycle %s did not probe r0" % sys.argv[2])
+for name in ("pull", "log", "diff"):
+    if (name in names) != (sys.argv[3] == "processed"):
+        sys.exit("probe: cycle %s: %s of r0 was %s" % (sys.argv[2], name
+            , "run" if name in names else "skipped"))
+print("probe: cycle %s %s r0" % (sys.argv[2], sys.argv[3]))
+PY
+}
+
+# count COUNT: check number of collected commits.
+count()
+{
+    COUNT=$(find difference/r0 -name '*.json' | wc -l)
+    if [ "$COUNT" -ne "$1" ]; then
+        echo "probe: $COUNT commits are collected instead of $1" >&2
+        exit 1
+    fi
+}
+
+cycle 1 processed
+count 1
+cycle 2 skipped
+
+python3 - "file://$REMOTE" <<'PY'
+import json, sys
+json.dump({"repositories": [{"name": "r0", "url": sys.argv[1]
+    , "refs": ["refs/remotes/origin/feature*"]}]}, open("repositories.json", "w"))
+PY
+cycle 3 processed
+count 2
+
+cd "$REMOTE"
+printf 'b\n' >> file.txt
+git commit -q -a -m 'second'
+cd "$WORK/collector"
+
+cycle 4 processed
+count 3